@@ -0,0 +1,95 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <PBB/ThreadPool.hpp>
+#include <PBB/ThreadPoolTags.hpp>
+
+// Scaling of a data-parallel loop split into one chunk per task on the
+// DefaultPool, with Arg chunks in flight. Strong scaling keeps the loop
+// size fixed, such that the ideal time is inversely proportional to the
+// parallelism, while weak scaling keeps the size of a chunk fixed, such
+// that the ideal time is constant.
+namespace
+{
+using PBB::Thread::TaskFuture;
+
+constexpr std::size_t StrongSize = std::size_t{ 1 } << 22;
+constexpr std::size_t WeakChunkSize = std::size_t{ 1 } << 18;
+
+void Kernel(const float* pInput, float* pOutput, std::size_t begin, std::size_t end) noexcept
+{
+    for (std::size_t i = begin; i < end; i++)
+    {
+        pOutput[i] = std::sqrt(pInput[i]) * 0.5f + std::sin(pInput[i]);
+    }
+}
+
+void RunChunked(benchmark::State& state, std::size_t size, std::size_t nChunks)
+{
+    auto& pool = PBB::Thread::ThreadPool<PBB::Thread::Tags::DefaultPool>::InstanceGet();
+    std::vector<float> input(size, 2.0f);
+    std::vector<float> output(size);
+    std::vector<TaskFuture<void>> futures;
+    futures.reserve(nChunks);
+    for (auto _ : state)
+    {
+        for (std::size_t chunk = 0; chunk < nChunks; chunk++)
+        {
+            const std::size_t begin = size * chunk / nChunks;
+            const std::size_t end = size * (chunk + 1) / nChunks;
+            futures.push_back(pool.Submit(
+              [pInput = input.data(), pOutput = output.data(), begin, end]() noexcept -> void
+              { Kernel(pInput, pOutput, begin, end); },
+              nullptr));
+        }
+        for (auto& future : futures)
+        {
+            future.Get();
+        }
+        futures.clear();
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(size));
+    state.counters["workers"] =
+      static_cast<double>(std::min<std::size_t>(nChunks, pool.NThreadsGet()));
+}
+
+void BM_ChunkedLoop_Strong(benchmark::State& state)
+{
+    RunChunked(state, StrongSize, static_cast<std::size_t>(state.range(0)));
+}
+
+void BM_ChunkedLoop_Weak(benchmark::State& state)
+{
+    const auto nChunks = static_cast<std::size_t>(state.range(0));
+    RunChunked(state, WeakChunkSize * nChunks, nChunks);
+}
+
+void Parallelism(benchmark::internal::Benchmark* b)
+{
+    const auto maxThreads =
+      static_cast<std::int64_t>(std::max(1u, std::thread::hardware_concurrency()));
+    for (std::int64_t chunks = 1; chunks < maxThreads; chunks *= 2)
+    {
+        b->Arg(chunks);
+    }
+    b->Arg(maxThreads);
+}
+} // namespace
+
+BENCHMARK(BM_ChunkedLoop_Strong)
+  ->Apply(Parallelism)
+  ->ArgName("chunks")
+  ->UseRealTime()
+  ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ChunkedLoop_Weak)
+  ->Apply(Parallelism)
+  ->ArgName("chunks")
+  ->UseRealTime()
+  ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,71 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+
+#include <PBB/Memory.hpp>
+
+// Each thread increments its own counter. Counters packed next to each
+// other false-share, whereas counters padded to a cache line (or to a
+// prefetch pair on hosts with an adjacent-line prefetcher) do not.
+namespace
+{
+constexpr std::size_t MaxThreads = 256;
+constexpr int IncrementsPerIteration = 1024;
+
+struct Counter
+{
+    std::atomic<long> value{ 0 };
+};
+
+template <typename Counters>
+void Increment(benchmark::State& state, Counters& counters)
+{
+    auto& counter = counters[static_cast<std::size_t>(state.thread_index())];
+    for (auto _ : state)
+    {
+        for (int i = 0; i < IncrementsPerIteration; i++)
+        {
+            counter.value.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * IncrementsPerIteration);
+}
+
+void BM_FalseSharing_Packed(benchmark::State& state)
+{
+    static Counter counters[MaxThreads];
+    Increment(state, counters);
+}
+
+void BM_FalseSharing_CacheLine(benchmark::State& state)
+{
+    static PBB::CacheAlignedArray<Counter, PBB::CACHE_LINE_SIZE> counters(MaxThreads);
+    state.counters["Stride"] = static_cast<double>(PBB::CACHE_LINE_SIZE);
+    Increment(state, counters);
+}
+
+void BM_FalseSharing_PrefetchPair(benchmark::State& state)
+{
+    static PBB::CacheAlignedArray<Counter, PBB::PREFETCH_PAIR_SIZE> counters(MaxThreads);
+    state.counters["Stride"] = static_cast<double>(PBB::PREFETCH_PAIR_SIZE);
+    Increment(state, counters);
+}
+
+void ThreadCounts(benchmark::internal::Benchmark* b)
+{
+    const int maxThreads = static_cast<int>(
+      std::min<std::size_t>(MaxThreads, std::max(1u, std::thread::hardware_concurrency())));
+    for (int nThreads = 1; nThreads < maxThreads; nThreads *= 2)
+    {
+        b->Threads(nThreads);
+    }
+    b->Threads(maxThreads);
+}
+} // namespace
+
+BENCHMARK(BM_FalseSharing_Packed)->Apply(ThreadCounts)->UseRealTime();
+BENCHMARK(BM_FalseSharing_CacheLine)->Apply(ThreadCounts)->UseRealTime();
+BENCHMARK(BM_FalseSharing_PrefetchPair)->Apply(ThreadCounts)->UseRealTime();
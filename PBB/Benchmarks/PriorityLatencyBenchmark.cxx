@@ -0,0 +1,86 @@
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+#include <PBB/ThreadPool.hpp>
+#include <PBB/ThreadPoolTags.hpp>
+
+// Latency of a single probe task submitted behind a saturating backlog
+// of background work, i.e. the time from Submit until the probe starts
+// executing. With priority lanes, a high-priority probe only waits for
+// the tasks already running, whereas a normal-priority probe waiting in
+// the same lane as the backlog waits for all of it.
+namespace
+{
+using Clock = std::chrono::steady_clock;
+using PBB::Thread::TaskFuture;
+using PBB::Thread::TaskPriority;
+
+void Spin(std::chrono::microseconds duration) noexcept
+{
+    const auto end = Clock::now() + duration;
+    while (Clock::now() < end)
+    {
+    }
+}
+
+void ProbeLatency(
+  benchmark::State& state, TaskPriority backgroundPriority, TaskPriority probePriority)
+{
+    auto& pool = PBB::Thread::ThreadPool<PBB::Thread::Tags::DefaultPool>::InstanceGet();
+    const auto nBackground = static_cast<std::size_t>(state.range(0)) * pool.NThreadsGet();
+    const std::chrono::microseconds chunk{ 20 };
+
+    std::vector<TaskFuture<void>> background;
+    background.reserve(nBackground);
+    for (auto _ : state)
+    {
+        for (std::size_t i = 0; i < nBackground; i++)
+        {
+            background.push_back(pool.Submit(
+              backgroundPriority, [chunk]() noexcept -> void { Spin(chunk); }, nullptr));
+        }
+
+        const auto submitted = Clock::now();
+        auto probe =
+          pool.Submit(probePriority, []() noexcept -> Clock::time_point { return Clock::now(); },
+            nullptr);
+        const auto started = probe.Get();
+        state.SetIterationTime(std::chrono::duration<double>(started - submitted).count());
+
+        for (auto& future : background)
+        {
+            future.Get();
+        }
+        background.clear();
+    }
+    state.counters["Backlog"] = static_cast<double>(nBackground);
+}
+
+void BM_ProbeLatency_Normal(benchmark::State& state)
+{
+    ProbeLatency(state, TaskPriority::Normal, TaskPriority::Normal);
+}
+
+void BM_ProbeLatency_HighOverBackground(benchmark::State& state)
+{
+    ProbeLatency(state, TaskPriority::Background, TaskPriority::High);
+}
+} // namespace
+
+// Backlog of Arg tasks per worker. The number of iterations is fixed,
+// since every iteration drains the backlog outside the measured time.
+BENCHMARK(BM_ProbeLatency_Normal)
+  ->Arg(16)
+  ->Arg(256)
+  ->Iterations(200)
+  ->UseManualTime()
+  ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_ProbeLatency_HighOverBackground)
+  ->Arg(16)
+  ->Arg(256)
+  ->Iterations(200)
+  ->UseManualTime()
+  ->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,121 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <barrier>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <PBB/MRMWQueue.hpp>
+
+// Throughput of MRMWQueue with 1..N producers and 1..N consumers, all
+// blocking. The threads are created once. Every iteration releases
+// them using a barrier and moves a fixed number of items per producer
+// through the queue, after which each consumer pops a sentinel.
+namespace
+{
+constexpr std::size_t ItemsPerProducer = 16 * 1024;
+
+void BM_MRMWQueue_ProducersConsumers(benchmark::State& state)
+{
+    const auto nProducers = static_cast<std::size_t>(state.range(0));
+    const auto nConsumers = static_cast<std::size_t>(state.range(1));
+    PBB::MRMWQueue<std::uint64_t> queue;
+
+    std::barrier start(static_cast<std::ptrdiff_t>(nProducers + nConsumers + 1));
+    std::barrier produced(static_cast<std::ptrdiff_t>(nProducers + 1));
+    std::barrier consumed(static_cast<std::ptrdiff_t>(nConsumers + 1));
+    bool stop = false; // Written before, read after arriving at start
+
+    std::vector<std::thread> threads;
+    for (std::size_t c = 0; c < nConsumers; c++)
+    {
+        threads.emplace_back(
+          [&]
+          {
+              for (;;)
+              {
+                  start.arrive_and_wait();
+                  if (stop)
+                  {
+                      return;
+                  }
+                  std::uint64_t item = 0;
+                  while (queue.Pop(item) && item != 0)
+                  {
+                      benchmark::DoNotOptimize(item);
+                  }
+                  consumed.arrive_and_wait();
+              }
+          });
+    }
+    for (std::size_t p = 0; p < nProducers; p++)
+    {
+        threads.emplace_back(
+          [&]
+          {
+              for (;;)
+              {
+                  start.arrive_and_wait();
+                  if (stop)
+                  {
+                      return;
+                  }
+                  for (std::size_t i = 0; i < ItemsPerProducer; i++)
+                  {
+                      queue.Push(std::uint64_t{ 1 });
+                  }
+                  produced.arrive_and_wait();
+              }
+          });
+    }
+
+    for (auto _ : state)
+    {
+        start.arrive_and_wait();
+        produced.arrive_and_wait();
+        for (std::size_t c = 0; c < nConsumers; c++)
+        {
+            queue.Push(std::uint64_t{ 0 });
+        }
+        consumed.arrive_and_wait();
+    }
+
+    stop = true;
+    start.arrive_and_wait();
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    state.SetItemsProcessed(
+      state.iterations() * static_cast<std::int64_t>(nProducers * ItemsPerProducer));
+}
+
+// Powers of two below the number of hardware threads and the number
+// itself, for producers and consumers
+void ProducerConsumerCounts(benchmark::internal::Benchmark* b)
+{
+    const auto maxThreads =
+      static_cast<std::int64_t>(std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<std::int64_t> counts;
+    for (std::int64_t count = 1; count < maxThreads; count *= 2)
+    {
+        counts.push_back(count);
+    }
+    counts.push_back(maxThreads);
+    for (const std::int64_t producers : counts)
+    {
+        for (const std::int64_t consumers : counts)
+        {
+            b->Args({ producers, consumers });
+        }
+    }
+}
+} // namespace
+
+BENCHMARK(BM_MRMWQueue_ProducersConsumers)
+  ->Apply(ProducerConsumerCounts)
+  ->ArgNames({ "producers", "consumers" })
+  ->UseRealTime()
+  ->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,101 @@
+#include <benchmark/benchmark.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+#include <PBB/MRMWQueue.hpp>
+
+// MRMWQueue, where consumers sleep on an atomic (futex) and pushes only
+// notify sleeping consumers after releasing the mutex, compared to a
+// queue notifying a condition variable inside the lock on every push.
+namespace
+{
+class CondVarQueue
+{
+  public:
+    bool Push(std::uint64_t&& item)
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        m_queue.push(item);
+        m_condition.notify_one();
+        return true;
+    }
+
+    bool Pop(std::uint64_t& item)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condition.wait(lock, [this] { return !m_queue.empty(); });
+        item = m_queue.front();
+        m_queue.pop();
+        return true;
+    }
+
+    bool TryPop(std::uint64_t& item)
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        if (m_queue.empty())
+        {
+            return false;
+        }
+        item = m_queue.front();
+        m_queue.pop();
+        return true;
+    }
+
+  private:
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::queue<std::uint64_t> m_queue;
+};
+
+// Push latency without sleeping consumers
+template <typename Queue>
+void BM_Push_NoSleepers(benchmark::State& state)
+{
+    Queue queue;
+    std::uint64_t item = 0;
+    for (auto _ : state)
+    {
+        queue.Push(std::uint64_t{ 1 });
+        queue.TryPop(item);
+    }
+    benchmark::DoNotOptimize(item);
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Round trips between two threads, each one waking the other twice
+template <typename Queue>
+void BM_PingPong(benchmark::State& state)
+{
+    Queue ping;
+    Queue pong;
+    std::thread partner(
+      [&]
+      {
+          std::uint64_t item = 0;
+          while (ping.Pop(item) && item != 0)
+          {
+              pong.Push(std::move(item));
+          }
+      });
+
+    std::uint64_t item = 0;
+    for (auto _ : state)
+    {
+        ping.Push(std::uint64_t{ 1 });
+        pong.Pop(item);
+    }
+    ping.Push(std::uint64_t{ 0 });
+    partner.join();
+    state.counters["wakeups"] = benchmark::Counter(
+      2.0 * static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+}
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_Push_NoSleepers, PBB::MRMWQueue<std::uint64_t>);
+BENCHMARK_TEMPLATE(BM_Push_NoSleepers, CondVarQueue);
+BENCHMARK_TEMPLATE(BM_PingPong, PBB::MRMWQueue<std::uint64_t>)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_PingPong, CondVarQueue)->UseRealTime();
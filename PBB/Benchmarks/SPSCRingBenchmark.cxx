@@ -0,0 +1,119 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+
+#include <PBB/MRMWQueue.hpp>
+#include <PBB/SPSCRing.hpp>
+
+// Throughput of small items from one producer thread to one consumer
+// thread. The benchmark thread produces, a separate thread consumes.
+// A side yields when the ring is full or empty.
+namespace
+{
+constexpr std::size_t Capacity = 4096;
+constexpr std::uint64_t ItemsPerIteration = 1 << 16;
+
+template <typename Produce, typename Consume>
+void Transfer(benchmark::State& state, Produce&& produce, Consume&& consume)
+{
+    std::uint64_t total = 0;
+    for (auto _ : state)
+    {
+        std::thread consumer([&] { consume(ItemsPerIteration); });
+        produce(ItemsPerIteration);
+        consumer.join();
+        total += ItemsPerIteration;
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(total));
+}
+
+void BM_SPSCRing_Single(benchmark::State& state)
+{
+    PBB::SPSCRing<std::uint64_t> ring(Capacity);
+    Transfer(
+      state,
+      [&](std::uint64_t n)
+      {
+          for (std::uint64_t i = 0; i < n;)
+          {
+              if (ring.TryPush(i))
+                  i++;
+              else
+                  std::this_thread::yield();
+          }
+      },
+      [&](std::uint64_t n)
+      {
+          std::uint64_t value = 0;
+          for (std::uint64_t i = 0; i < n;)
+          {
+              if (ring.TryPop(value))
+                  i++;
+              else
+                  std::this_thread::yield();
+          }
+          benchmark::DoNotOptimize(value);
+      });
+}
+
+void BM_SPSCRing_Batch(benchmark::State& state)
+{
+    PBB::SPSCRing<std::uint64_t> ring(Capacity);
+    const auto batchSize = static_cast<std::size_t>(state.range(0));
+    Transfer(
+      state,
+      [&](std::uint64_t n)
+      {
+          std::uint64_t batch[256] = {};
+          for (std::uint64_t i = 0; i < n;)
+          {
+              const std::size_t pushed =
+                ring.TryPushBatch(batch, std::min<std::uint64_t>(batchSize, n - i));
+              if (pushed == 0)
+                  std::this_thread::yield();
+              i += pushed;
+          }
+      },
+      [&](std::uint64_t n)
+      {
+          std::uint64_t batch[256] = {};
+          for (std::uint64_t i = 0; i < n;)
+          {
+              const std::size_t popped = ring.TryPopBatch(batch, batchSize);
+              if (popped == 0)
+                  std::this_thread::yield();
+              i += popped;
+          }
+          benchmark::DoNotOptimize(batch);
+      });
+}
+
+void BM_MRMWQueue_Baseline(benchmark::State& state)
+{
+    PBB::MRMWQueue<std::uint64_t> queue;
+    Transfer(
+      state,
+      [&](std::uint64_t n)
+      {
+          for (std::uint64_t i = 0; i < n; i++)
+          {
+              queue.Push(i);
+          }
+      },
+      [&](std::uint64_t n)
+      {
+          std::uint64_t value = 0;
+          for (std::uint64_t i = 0; i < n; i++)
+          {
+              queue.Pop(value);
+          }
+          benchmark::DoNotOptimize(value);
+      });
+}
+} // namespace
+
+BENCHMARK(BM_SPSCRing_Single)->UseRealTime();
+BENCHMARK(BM_SPSCRing_Batch)->Arg(16)->Arg(256)->UseRealTime();
+BENCHMARK(BM_MRMWQueue_Baseline)->UseRealTime();
@@ -0,0 +1,376 @@
+/**
+ * @file   Scaling.cxx
+ * @author Jens Munk Hansen <jens.munk.hansen@gmail.com>
+ * @date   Thu Oct 22 09:12:40 CEST 2026
+ *
+ * @brief  pbb-scaling, sweep of thread counts and task granularities
+ *
+ * For each thread count, the harness runs itself in a child process
+ * with PBB_NUM_THREADS set, since the size of a pool is fixed when it
+ * is created. A child submits busy-waiting tasks of each granularity,
+ * keeping a window of tasks in flight, and reports a CSV row per
+ * granularity, for a given duration:
+ *
+ *   throughput  Tasks completed per second
+ *   efficiency  Task time over the wall time of all workers, i.e. the
+ *               fraction of the pool doing useful work
+ *   p50/p99     Queue delay from Submit until a worker starts the task,
+ *               from a histogram with a relative error below 1/16
+ *
+ * The queue backend is chosen when PBB is configured, e.g. using
+ * PBB_USE_TBB_QUEUE or PBB_USE_SHARDED_QUEUE, and reported in a column,
+ * such that the reports of several builds can be concatenated.
+ *
+ * Usage: pbb-scaling [--threads=1,2,4] [--grains-ns=100,1000]
+ *                    [--duration-ms=200] [--pool=default|custom]
+ *                    [--format=csv|json] [--output=file]
+ *
+ * Copyright 2025 Jens Munk Hansen
+ *
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <PBB/LatencyHistogram.hpp>
+#include <PBB/ThreadPool.hpp>
+#include <PBB/ThreadPoolCustom.hpp>
+#include <PBB/ThreadPoolTags.hpp>
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#endif
+
+namespace
+{
+using Steady = std::chrono::steady_clock;
+using PBB::Thread::TaskFuture;
+using PBB::Thread::ThreadPool;
+namespace Tags = PBB::Thread::Tags;
+
+constexpr const char* CsvHeader =
+  "backend,pool,threads,grain_ns,tasks,seconds,throughput,efficiency,p50_ns,p99_ns";
+
+const char* Backend()
+{
+#if defined(PBB_USE_TBB_QUEUE)
+    return "TBB";
+#elif defined(PBB_USE_SHARDED_QUEUE)
+    return "ShardedMRMWQueue";
+#else
+    return "MRMWQueue";
+#endif
+}
+
+struct Options
+{
+    std::vector<std::size_t> threads;
+    std::vector<std::int64_t> grains{ 100, 1000, 10000, 100000, 1000000 };
+    std::chrono::milliseconds duration{ 200 };
+    std::string pool{ "default" };
+    std::string format{ "csv" };
+    std::string output;
+    bool child{ false };
+};
+
+// Throws std::invalid_argument or std::out_of_range for malformed numbers
+template <typename T>
+std::vector<T> ParseList(const std::string& text)
+{
+    std::vector<T> values;
+    std::istringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ','))
+    {
+        values.push_back(static_cast<T>(std::stoll(item)));
+    }
+    return values;
+}
+
+// Powers of two up to the number of hardware threads, and the number itself
+std::vector<std::size_t> DefaultThreadCounts()
+{
+    const std::size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::size_t> counts;
+    for (std::size_t n = 1; n < cores; n *= 2)
+    {
+        counts.push_back(n);
+    }
+    counts.push_back(cores);
+    return counts;
+}
+
+void PrintUsage(const char* executable)
+{
+    std::cerr << "Usage: " << executable
+              << " [--threads=1,2,4] [--grains-ns=100,1000] [--duration-ms=200]"
+                 " [--pool=default|custom] [--format=csv|json] [--output=file]\n";
+}
+
+bool Parse(int argc, char* argv[], Options& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string argument = argv[i];
+        const auto equals = argument.find('=');
+        const std::string key = argument.substr(0, equals);
+        const std::string value = equals == std::string::npos ? "" : argument.substr(equals + 1);
+        try
+        {
+            if (key == "--threads")
+                options.threads = ParseList<std::size_t>(value);
+            else if (key == "--grains-ns")
+                options.grains = ParseList<std::int64_t>(value);
+            else if (key == "--duration-ms")
+                options.duration = std::chrono::milliseconds(std::stoll(value));
+            else if (key == "--pool" && (value == "default" || value == "custom"))
+                options.pool = value;
+            else if (key == "--format" && (value == "csv" || value == "json"))
+                options.format = value;
+            else if (key == "--output")
+                options.output = value;
+            else if (key == "--child")
+                options.child = true;
+            else
+            {
+                std::cerr << "Unknown argument: " << argument << "\n";
+                PrintUsage(argv[0]);
+                return false;
+            }
+        }
+        catch (const std::logic_error&)
+        {
+            // std::invalid_argument or std::out_of_range from std::stoll
+            std::cerr << "Invalid value: " << argument << "\n";
+            PrintUsage(argv[0]);
+            return false;
+        }
+    }
+    if (options.threads.empty())
+    {
+        options.threads = DefaultThreadCounts();
+    }
+    return true;
+}
+
+void Spin(std::chrono::nanoseconds duration) noexcept
+{
+    const auto end = Steady::now() + duration;
+    while (Steady::now() < end)
+    {
+    }
+}
+
+// Run one granularity on the pool of this process and print a CSV row
+template <typename Tag>
+void RunGrain(const Options& options, std::int64_t grainNs)
+{
+    auto& pool = ThreadPool<Tag>::InstanceGet();
+    const std::size_t nThreads = pool.NThreadsGet();
+    const std::chrono::nanoseconds grain{ grainNs };
+    // Enough tasks in flight to keep every worker busy, without
+    // measuring the delay of a long backlog
+    const std::size_t window = 4 * nThreads;
+
+    // One slot per task in flight, reused once its task has completed,
+    // such that the submitter does not allocate or grow per task. The
+    // queue delays are recorded by the submitter in a histogram.
+    std::vector<Steady::time_point> started(window);
+    std::vector<Steady::time_point> submitted(window);
+    std::vector<TaskFuture<void>> futures;
+    futures.reserve(window);
+    PBB::LatencyHistogram delays;
+    const auto complete = [&](std::size_t slot)
+    {
+        futures[slot].Get();
+        const auto delay = std::chrono::duration_cast<std::chrono::nanoseconds>(
+          started[slot] - submitted[slot]);
+        delays.Record(static_cast<std::uint64_t>(std::max<std::int64_t>(delay.count(), 0)));
+    };
+
+    const auto begin = Steady::now();
+    std::size_t nTasks = 0;
+    for (; nTasks < window || Steady::now() - begin < options.duration; nTasks++)
+    {
+        const std::size_t slot = nTasks % window;
+        if (nTasks >= window)
+        {
+            complete(slot);
+        }
+        submitted[slot] = Steady::now();
+        auto future = pool.Submit(
+          [pStarted = &started[slot], grain]() noexcept -> void
+          {
+              *pStarted = Steady::now();
+              Spin(grain);
+          },
+          nullptr);
+        if (nTasks < window)
+        {
+            futures.push_back(std::move(future));
+        }
+        else
+        {
+            futures[slot] = std::move(future);
+        }
+    }
+    for (std::size_t i = nTasks - window; i < nTasks; i++)
+    {
+        complete(i % window);
+    }
+    const double seconds = std::chrono::duration<double>(Steady::now() - begin).count();
+
+    const double busy = static_cast<double>(nTasks) * static_cast<double>(grainNs) * 1e-9;
+    std::cout << Backend() << ',' << options.pool << ',' << nThreads << ',' << grainNs << ','
+              << nTasks << ',' << seconds << ',' << static_cast<double>(nTasks) / seconds << ','
+              << busy / (seconds * static_cast<double>(nThreads)) << ','
+              << delays.ValueAtFraction(0.5) << ',' << delays.ValueAtFraction(0.99) << std::endl;
+}
+
+int RunChild(const Options& options)
+{
+    for (const std::int64_t grain : options.grains)
+    {
+        if (options.pool == "custom")
+            RunGrain<Tags::CustomPool>(options, grain);
+        else
+            RunGrain<Tags::DefaultPool>(options, grain);
+    }
+    return 0;
+}
+
+// Run a child process per thread count and collect its rows
+bool CollectRows(const char* executable, const Options& options, std::vector<std::string>& rows)
+{
+    std::ostringstream grains;
+    for (std::size_t i = 0; i < options.grains.size(); i++)
+    {
+        grains << (i ? "," : "") << options.grains[i];
+    }
+    for (const std::size_t threads : options.threads)
+    {
+        const std::string command = std::string("\"") + executable + "\" --child --pool=" +
+          options.pool + " --grains-ns=" + grains.str() +
+          " --duration-ms=" + std::to_string(options.duration.count());
+#ifdef _WIN32
+        _putenv_s("PBB_NUM_THREADS", std::to_string(threads).c_str());
+#else
+        setenv("PBB_NUM_THREADS", std::to_string(threads).c_str(), 1);
+#endif
+        std::cerr << "Running " << threads << " thread(s)" << std::endl;
+        FILE* pPipe = popen(command.c_str(), "r");
+        if (!pPipe)
+        {
+            std::cerr << "Failed to run " << command << std::endl;
+            return false;
+        }
+        char line[512];
+        while (std::fgets(line, sizeof(line), pPipe))
+        {
+            std::string row(line);
+            while (!row.empty() && (row.back() == '\n' || row.back() == '\r'))
+            {
+                row.pop_back();
+            }
+            rows.push_back(row);
+        }
+        if (pclose(pPipe) != 0)
+        {
+            std::cerr << "Child for " << threads << " thread(s) failed" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+void WriteJson(std::ostream& os, const std::vector<std::string>& rows)
+{
+    const std::vector<std::string> keys = []()
+    {
+        std::vector<std::string> names;
+        std::istringstream stream(CsvHeader);
+        std::string name;
+        while (std::getline(stream, name, ','))
+        {
+            names.push_back(name);
+        }
+        return names;
+    }();
+
+    os << "{\n  \"hardware_concurrency\": " << std::thread::hardware_concurrency()
+       << ",\n  \"results\": [";
+    for (std::size_t r = 0; r < rows.size(); r++)
+    {
+        os << (r ? ",\n    {" : "\n    {");
+        std::istringstream stream(rows[r]);
+        std::string field;
+        for (std::size_t k = 0; k < keys.size() && std::getline(stream, field, ','); k++)
+        {
+            os << (k ? ", " : "") << '"' << keys[k] << "\": ";
+            // backend and pool are strings, the rest numbers
+            if (k < 2)
+                os << '"' << field << '"';
+            else
+                os << field;
+        }
+        os << '}';
+    }
+    os << "\n  ]\n}\n";
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    if (!Parse(argc, argv, options))
+    {
+        return EXIT_FAILURE;
+    }
+    if (options.child)
+    {
+        return RunChild(options);
+    }
+
+    std::vector<std::string> rows;
+    if (!CollectRows(argv[0], options, rows))
+    {
+        return EXIT_FAILURE;
+    }
+
+    std::ofstream file;
+    if (!options.output.empty())
+    {
+        file.open(options.output);
+        if (!file)
+        {
+            std::cerr << "Cannot open " << options.output << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    std::ostream& os = options.output.empty() ? std::cout : file;
+    if (options.format == "json")
+    {
+        WriteJson(os, rows);
+    }
+    else
+    {
+        os << CsvHeader << "\n";
+        for (const auto& row : rows)
+        {
+            os << row << "\n";
+        }
+    }
+    return EXIT_SUCCESS;
+}
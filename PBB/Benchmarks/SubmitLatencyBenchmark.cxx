@@ -0,0 +1,57 @@
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <vector>
+
+#include <PBB/ThreadPool.hpp>
+#include <PBB/ThreadPoolCustom.hpp>
+#include <PBB/ThreadPoolTags.hpp>
+
+// Round trip of a single empty task, from Submit until Get returns,
+// i.e. task allocation, queueing, waking a worker and fulfilling the
+// future. The batched variant submits Arg tasks before waiting for any,
+// which measures the throughput of the pool instead of its latency.
+namespace
+{
+using PBB::Thread::TaskFuture;
+using PBB::Thread::ThreadPool;
+namespace Tags = PBB::Thread::Tags;
+
+template <typename Tag>
+void BM_Submit_RoundTrip(benchmark::State& state)
+{
+    auto& pool = ThreadPool<Tag>::InstanceGet();
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(pool.Submit([]() noexcept -> int { return 1; }, nullptr).Get());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+template <typename Tag>
+void BM_Submit_Batch(benchmark::State& state)
+{
+    auto& pool = ThreadPool<Tag>::InstanceGet();
+    const auto nTasks = static_cast<std::size_t>(state.range(0));
+    std::vector<TaskFuture<int>> futures;
+    futures.reserve(nTasks);
+    for (auto _ : state)
+    {
+        for (std::size_t i = 0; i < nTasks; i++)
+        {
+            futures.push_back(pool.Submit([]() noexcept -> int { return 1; }, nullptr));
+        }
+        for (auto& future : futures)
+        {
+            benchmark::DoNotOptimize(future.Get());
+        }
+        futures.clear();
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(nTasks));
+}
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_Submit_RoundTrip, Tags::DefaultPool)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Submit_RoundTrip, Tags::CustomPool)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Submit_Batch, Tags::DefaultPool)->Arg(64)->Arg(4096)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Submit_Batch, Tags::CustomPool)->Arg(64)->Arg(4096)->UseRealTime();
@@ -0,0 +1,140 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+#include <PBB/ThreadPool.hpp>
+#include <PBB/ThreadPoolCustom.hpp>
+#include <PBB/ThreadPoolTags.hpp>
+
+// Round-trip of small tasks through a pool, reporting the number of
+// heap allocations per task. Configure with -DPBB_USE_TASK_POOL=OFF
+// to obtain the baseline, where every task, shared state and promise
+// is allocated from the global heap.
+namespace
+{
+std::atomic<std::size_t> g_allocations{ 0 };
+
+void* CountedAllocate(std::size_t size, std::size_t alignment)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (size == 0)
+    {
+        size = 1;
+    }
+#ifdef _WIN32
+    // Memory from _aligned_malloc must be released using _aligned_free,
+    // which cannot tell the allocations apart, so it is used for all
+    void* p = _aligned_malloc(size, std::max(alignment, alignof(std::max_align_t)));
+#else
+    void* p = alignment > alignof(std::max_align_t)
+      ? std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)
+      : std::malloc(size);
+#endif
+    if (!p)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+} // namespace
+
+// GCC warns about free() on memory from operator new, once the
+// replacements are inlined into their callers
+#if defined(__GNUC__) && !defined(__clang__) && (__GNUC__ >= 11)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+namespace
+{
+void CountedFree(void* p) noexcept
+{
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+} // namespace
+
+void* operator new(std::size_t size)
+{
+    return CountedAllocate(size, alignof(std::max_align_t));
+}
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    return CountedAllocate(size, static_cast<std::size_t>(alignment));
+}
+void operator delete(void* p) noexcept
+{
+    CountedFree(p);
+}
+void operator delete(void* p, std::size_t) noexcept
+{
+    CountedFree(p);
+}
+void operator delete(void* p, std::align_val_t) noexcept
+{
+    CountedFree(p);
+}
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept
+{
+    CountedFree(p);
+}
+#if defined(__GNUC__) && !defined(__clang__) && (__GNUC__ >= 11)
+#pragma GCC diagnostic pop
+#endif
+
+namespace
+{
+template <typename Tag>
+void SubmitRoundTrip(benchmark::State& state)
+{
+    auto& pool = PBB::Thread::ThreadPool<Tag>::InstanceGet();
+    const auto nTasks = static_cast<std::size_t>(state.range(0));
+
+    std::vector<PBB::Thread::TaskFuture<std::size_t>> futures;
+    futures.reserve(nTasks);
+
+    std::size_t allocations = 0;
+    for (auto _ : state)
+    {
+        const std::size_t before = g_allocations.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < nTasks; i++)
+        {
+            futures.push_back(pool.Submit([i]() noexcept { return i; }, nullptr));
+        }
+        std::size_t sum = 0;
+        for (auto& future : futures)
+        {
+            sum += future.Get();
+        }
+        futures.clear();
+        allocations += g_allocations.load(std::memory_order_relaxed) - before;
+        benchmark::DoNotOptimize(sum);
+    }
+    const auto tasks = static_cast<double>(state.iterations()) * static_cast<double>(nTasks);
+    state.SetItemsProcessed(static_cast<int64_t>(tasks));
+    state.counters["Allocs/task"] = static_cast<double>(allocations) / tasks;
+}
+
+void BM_Submit_DefaultPool(benchmark::State& state)
+{
+    SubmitRoundTrip<PBB::Thread::Tags::DefaultPool>(state);
+}
+
+void BM_Submit_CustomPool(benchmark::State& state)
+{
+    SubmitRoundTrip<PBB::Thread::Tags::CustomPool>(state);
+}
+} // namespace
+
+BENCHMARK(BM_Submit_DefaultPool)->Arg(64)->Arg(1024)->UseRealTime();
+BENCHMARK(BM_Submit_CustomPool)->Arg(64)->Arg(1024)->UseRealTime();
@@ -0,0 +1,53 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <thread>
+
+#include <PBB/ThreadLocal.hpp>
+
+// Cost of ThreadLocal::Local() once the value of the calling thread
+// exists, i.e. a lookup keyed by the thread id, when called by 1..N
+// threads concurrently. A C++ thread_local variable is the baseline.
+namespace
+{
+constexpr int AccessesPerIteration = 64;
+
+void BM_ThreadLocal_Local(benchmark::State& state)
+{
+    static PBB::ThreadLocal<long> values;
+    for (auto _ : state)
+    {
+        for (int i = 0; i < AccessesPerIteration; i++)
+        {
+            long& value = values.Local();
+            value++;
+            benchmark::DoNotOptimize(value);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * AccessesPerIteration);
+}
+
+void BM_ThreadLocal_Native(benchmark::State& state)
+{
+    thread_local long value = 0;
+    for (auto _ : state)
+    {
+        for (int i = 0; i < AccessesPerIteration; i++)
+        {
+            long* pValue = &value;
+            benchmark::DoNotOptimize(pValue);
+            (*pValue)++;
+            benchmark::DoNotOptimize(*pValue);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * AccessesPerIteration);
+}
+
+int MaxThreads()
+{
+    return static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+}
+} // namespace
+
+BENCHMARK(BM_ThreadLocal_Local)->ThreadRange(1, MaxThreads())->UseRealTime();
+BENCHMARK(BM_ThreadLocal_Native)->ThreadRange(1, MaxThreads())->UseRealTime();
@@ -0,0 +1,273 @@
+/**
+ * @file   BroadcastRing.hpp
+ * @author Jens Munk Hansen <jens.munk.hansen@gmail.com>
+ * @date   Mon Oct 19 16:05:12 CEST 2026
+ *
+ * @brief  Single-producer multi-consumer broadcast ring buffer
+ *
+ * Copyright 2025 Jens Munk Hansen
+ *
+ */
+#pragma once
+
+#if __cplusplus < 202002L
+#error "This header requires at least C++20"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <PBB/Common.hpp>
+#include <PBB/Memory.hpp>
+
+namespace PBB
+{
+namespace detail::v20
+{
+//! BroadcastRing
+/*!
+  Ring buffer delivering every item of a single producer to a fixed
+  number of consumers (fan-out). Each item is written once, in place,
+  and read in place by all consumers.
+
+  Every consumer owns a sequence, i.e. the number of items it has
+  consumed, padded to its own cache line. The producer can only reuse
+  a slot after the slowest consumer has consumed it. The position of
+  the slowest consumer is cached by the producer, such that consumer
+  sequences are only scanned when the ring appears full.
+
+  The Try variants never block. Claim() and Wait() block using atomic
+  waits, until room, respectively an item, is available. Blocked
+  threads are counted, such that Publish() and Consume() only issue a
+  wake-up when a thread is waiting.
+ */
+template <typename T>
+requires std::is_default_constructible_v<T>
+class BroadcastRing
+{
+  public:
+    /**
+     * Constructor
+     *
+     * @param capacity - minimum capacity, rounded up to a power of two
+     * @param nConsumers - number of consumers, identified by [0, nConsumers)
+     */
+    BroadcastRing(std::size_t capacity, std::size_t nConsumers)
+      : m_slots(std::bit_ceil(std::max<std::size_t>(capacity, 2)))
+      , m_mask(m_slots.size() - 1)
+      , m_consumed(std::max<std::size_t>(nConsumers, 1))
+    {
+    }
+    PBB_DELETE_COPY_CTORS(BroadcastRing);
+
+    std::size_t Capacity() const noexcept { return m_mask + 1; }
+    std::size_t NConsumersGet() const noexcept { return m_consumed.size(); }
+
+    // Producer
+
+    /**
+     * Slot for writing the next item in place. The item is published
+     * to all consumers by Publish(). Until then, TryClaim() returns the
+     * same slot.
+     *
+     * @return Slot or nullptr if the slowest consumer has not consumed
+     *         the item last written to it
+     */
+    T* TryClaim() noexcept
+    {
+        const std::uint64_t published = m_published.load(std::memory_order_relaxed);
+        return HasRoom(published) ? &m_slots[published & m_mask] : nullptr;
+    }
+
+    /**
+     * Slot for writing the next item in place, waiting for the slowest
+     * consumer if the ring is full
+     */
+    T* Claim() noexcept
+    {
+        const std::uint64_t published = m_published.load(std::memory_order_relaxed);
+        while (!HasRoom(published))
+        {
+            // Wait for the consumer holding back the producer
+            const std::size_t slowest = SlowestConsumer();
+            const std::uint64_t consumed = m_consumed[slowest].load(std::memory_order_acquire);
+            if (published - consumed >= Capacity())
+            {
+                // Register before the wait reloads the sequence, such
+                // that either Consume() sees the waiter or the wait
+                // sees the new sequence
+                m_producerWaiters.fetch_add(1, std::memory_order_seq_cst);
+                m_consumed[slowest].wait(consumed, std::memory_order_seq_cst);
+                m_producerWaiters.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+        return &m_slots[published & m_mask];
+    }
+
+    /**
+     * Publish the slot obtained from Claim() or TryClaim()
+     */
+    void Publish() noexcept
+    {
+        m_published.store(
+          m_published.load(std::memory_order_relaxed) + 1, std::memory_order_seq_cst);
+        if (m_consumerWaiters.load(std::memory_order_seq_cst) != 0)
+        {
+            m_published.notify_all();
+        }
+    }
+
+    bool TryPush(const T& item) noexcept(std::is_nothrow_copy_assignable_v<T>)
+    {
+        T* pSlot = TryClaim();
+        if (!pSlot)
+        {
+            return false;
+        }
+        *pSlot = item;
+        Publish();
+        return true;
+    }
+
+    bool TryPush(T&& item) noexcept(std::is_nothrow_move_assignable_v<T>)
+    {
+        T* pSlot = TryClaim();
+        if (!pSlot)
+        {
+            return false;
+        }
+        *pSlot = std::move(item);
+        Publish();
+        return true;
+    }
+
+    // Consumers, each consumer index must only be used by one thread
+
+    /**
+     * Next item of a consumer for reading in place. The slot is
+     * released by Consume().
+     *
+     * @param consumer - consumer index
+     * @return Item or nullptr if the consumer has read all items
+     */
+    const T* TryPeek(std::size_t consumer) const noexcept
+    {
+        const std::uint64_t consumed = m_consumed[consumer].load(std::memory_order_relaxed);
+        if (consumed == m_published.load(std::memory_order_acquire))
+        {
+            return nullptr;
+        }
+        return &m_slots[consumed & m_mask];
+    }
+
+    /**
+     * Next item of a consumer for reading in place, waiting for the
+     * producer to publish it
+     */
+    const T* Wait(std::size_t consumer) const noexcept
+    {
+        const std::uint64_t consumed = m_consumed[consumer].load(std::memory_order_relaxed);
+        std::uint64_t published = m_published.load(std::memory_order_acquire);
+        while (consumed == published)
+        {
+            m_consumerWaiters.fetch_add(1, std::memory_order_seq_cst);
+            m_published.wait(published, std::memory_order_seq_cst);
+            m_consumerWaiters.fetch_sub(1, std::memory_order_relaxed);
+            published = m_published.load(std::memory_order_acquire);
+        }
+        return &m_slots[consumed & m_mask];
+    }
+
+    /**
+     * Number of items published, which a consumer has not consumed
+     */
+    std::size_t Available(std::size_t consumer) const noexcept
+    {
+        return static_cast<std::size_t>(m_published.load(std::memory_order_acquire) -
+          m_consumed[consumer].load(std::memory_order_relaxed));
+    }
+
+    /**
+     * Release the oldest count items of a consumer, obtained using
+     * TryPeek(), Wait() or Available()
+     */
+    void Consume(std::size_t consumer, std::size_t count = 1) noexcept
+    {
+        auto& consumed = m_consumed[consumer];
+        consumed.store(consumed.load(std::memory_order_relaxed) + count, std::memory_order_seq_cst);
+        if (m_producerWaiters.load(std::memory_order_seq_cst) != 0)
+        {
+            consumed.notify_one();
+        }
+    }
+
+    /**
+     * Item at an offset from the next item of a consumer, where offset
+     * is less than Available(consumer)
+     */
+    const T& At(std::size_t consumer, std::size_t offset) const noexcept
+    {
+        return m_slots[(m_consumed[consumer].load(std::memory_order_relaxed) + offset) & m_mask];
+    }
+
+  private:
+    // Index of the consumer with the fewest items consumed (producer)
+    std::size_t SlowestConsumer() const noexcept
+    {
+        std::size_t slowest = 0;
+        std::uint64_t minimum = std::numeric_limits<std::uint64_t>::max();
+        for (std::size_t i = 0; i < m_consumed.size(); i++)
+        {
+            const std::uint64_t consumed = m_consumed[i].load(std::memory_order_acquire);
+            if (consumed < minimum)
+            {
+                minimum = consumed;
+                slowest = i;
+            }
+        }
+        return slowest;
+    }
+
+    bool HasRoom(std::uint64_t published) noexcept
+    {
+        if (published - m_cachedMinimum < Capacity())
+        {
+            return true;
+        }
+        std::uint64_t minimum = std::numeric_limits<std::uint64_t>::max();
+        for (const auto& consumed : m_consumed)
+        {
+            minimum = std::min(minimum, consumed.load(std::memory_order_acquire));
+        }
+        m_cachedMinimum = minimum;
+        return published - m_cachedMinimum < Capacity();
+    }
+
+    // Producer line
+    alignas(PREFETCH_PAIR_SIZE) std::atomic<std::uint64_t> m_published{ 0 };
+    std::uint64_t m_cachedMinimum{ 0 };
+    mutable std::atomic<std::uint32_t> m_consumerWaiters{ 0 }; ///< Consumers blocked in Wait()
+
+    // Read by every Consume(), only written by a blocked producer
+    alignas(PREFETCH_PAIR_SIZE) std::atomic<std::uint32_t> m_producerWaiters{ 0 };
+
+    // Shared, read-only after construction
+    alignas(PREFETCH_PAIR_SIZE) std::vector<T> m_slots;
+    const std::size_t m_mask;
+
+    // One line per consumer
+    CacheAlignedArray<std::atomic<std::uint64_t>, PREFETCH_PAIR_SIZE> m_consumed;
+};
+
+} // namespace detail::v20
+
+template <typename T>
+using BroadcastRing = detail::v20::BroadcastRing<T>;
+} // namespace PBB
@@ -0,0 +1,143 @@
+/**
+ * @file   Clock.hpp
+ * @author Jens Munk Hansen <jens.munk.hansen@gmail.com>
+ * @date   Tue Oct 20 16:41:05 CEST 2026
+ *
+ * @brief  Low-overhead clock based on the time-stamp counter
+ *
+ * Copyright 2025 Jens Munk Hansen
+ *
+ */
+#pragma once
+
+#if __cplusplus < 202002L
+#error "This header requires at least C++20"
+#endif
+
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+#endif
+
+namespace PBB
+{
+//! Clock
+/*!
+  Monotonic clock for timestamping on hot paths. On x86-64 with an
+  invariant time-stamp counter, and on AArch64, a tick is a counter
+  increment, which takes a few nanoseconds to read. Elsewhere ticks are
+  steady_clock nanoseconds.
+
+  Ticks are converted to durations using a ratio calibrated against
+  steady_clock on first use, which spins for CalibrationTime. Record
+  ticks and convert them when reporting, such that the calibration
+  never runs on a hot path.
+ */
+class Clock
+{
+  public:
+    using Ticks = std::uint64_t;
+
+    static constexpr std::chrono::milliseconds CalibrationTime{ 10 };
+
+    static Ticks Now() noexcept
+    {
+#if defined(__x86_64__) || defined(_M_X64)
+        if (CounterBased())
+        {
+            return __rdtsc();
+        }
+#elif defined(__aarch64__)
+        Ticks ticks;
+        asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+        return ticks;
+#endif
+        return static_cast<Ticks>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+                                    .count());
+    }
+
+    /**
+     * Whether ticks are read from a hardware counter
+     */
+    static bool CounterBased() noexcept
+    {
+#if defined(__x86_64__) || defined(_M_X64)
+        static const bool invariant = InvariantTsc();
+        return invariant;
+#elif defined(__aarch64__)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * Calibrated duration of a tick
+     */
+    static double NanosecondsPerTick() noexcept
+    {
+        static const double ratio = Calibrate();
+        return ratio;
+    }
+
+    static std::chrono::nanoseconds ToDuration(Ticks ticks) noexcept
+    {
+        return std::chrono::nanoseconds(
+          static_cast<std::int64_t>(static_cast<double>(ticks) * NanosecondsPerTick()));
+    }
+
+  private:
+#if defined(__x86_64__) || defined(_M_X64)
+    // CPUID.80000007H:EDX[8], the counter runs at a constant rate in all power states
+    static bool InvariantTsc() noexcept
+    {
+#ifdef _MSC_VER
+        int registers[4] = {};
+        __cpuid(registers, static_cast<int>(0x80000000u));
+        if (static_cast<unsigned>(registers[0]) < 0x80000007u)
+        {
+            return false;
+        }
+        __cpuid(registers, static_cast<int>(0x80000007u));
+        return (registers[3] & (1 << 8)) != 0;
+#else
+        unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+        if (__get_cpuid(0x80000007u, &eax, &ebx, &ecx, &edx) == 0)
+        {
+            return false;
+        }
+        return (edx & (1u << 8)) != 0;
+#endif
+    }
+#endif
+
+    static double Calibrate() noexcept
+    {
+        if (!CounterBased())
+        {
+            return 1.0;
+        }
+        using Steady = std::chrono::steady_clock;
+        const auto start = Steady::now();
+        const Ticks startTicks = Now();
+        auto end = start;
+        while (end - start < CalibrationTime)
+        {
+            end = Steady::now();
+        }
+        const Ticks endTicks = Now();
+        const double elapsed = static_cast<double>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        return endTicks > startTicks ? elapsed / static_cast<double>(endTicks - startTicks) : 1.0;
+    }
+};
+
+} // namespace PBB
@@ -0,0 +1,205 @@
+/**
+ * @file   LatencyHistogram.hpp
+ * @author Jens Munk Hansen <jens.munk.hansen@gmail.com>
+ * @date   Tue Oct 20 16:58:32 CEST 2026
+ *
+ * @brief  Log-linear histogram for latency percentiles
+ *
+ * Copyright 2025 Jens Munk Hansen
+ *
+ */
+#pragma once
+
+#if __cplusplus < 202002L
+#error "This header requires at least C++20"
+#endif
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include <PBB/Clock.hpp>
+
+namespace PBB
+{
+//! LatencyPercentiles
+/*!
+  Percentiles of a latency distribution
+ */
+struct LatencyPercentiles
+{
+    std::uint64_t count{ 0 }; ///< Number of samples
+    std::chrono::nanoseconds p50{ 0 };
+    std::chrono::nanoseconds p99{ 0 };
+    std::chrono::nanoseconds p999{ 0 };
+};
+
+namespace detail::v20
+{
+//! LatencyHistogram
+/*!
+  Log-linear (HDR-style) histogram of 64-bit values. Each power of two
+  is split into SubBuckets linear buckets, such that the relative error
+  of a reported value is below 1 / SubBuckets, and values below
+  2 * SubBuckets are exact.
+
+  Record() must be called by a single thread, while Merge() and the
+  percentile queries may run concurrently from other threads.
+ */
+class LatencyHistogram
+{
+  public:
+    static constexpr unsigned SubBucketBits = 4;
+    static constexpr std::size_t SubBuckets = std::size_t{ 1 } << SubBucketBits;
+    static constexpr std::size_t BucketCount = (64 - SubBucketBits + 1) * SubBuckets;
+
+    LatencyHistogram() noexcept = default;
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    static std::size_t BucketIndex(std::uint64_t value) noexcept
+    {
+        const unsigned msb = static_cast<unsigned>(std::bit_width(value | 1)) - 1;
+        if (msb <= SubBucketBits)
+        {
+            return static_cast<std::size_t>(value);
+        }
+        const unsigned shift = msb - SubBucketBits;
+        return ((static_cast<std::size_t>(shift) + 1) << SubBucketBits) |
+          static_cast<std::size_t>((value >> shift) & (SubBuckets - 1));
+    }
+
+    /**
+     * Value representing a bucket, the middle of its range
+     */
+    static std::uint64_t BucketValue(std::size_t index) noexcept
+    {
+        const std::size_t group = index >> SubBucketBits;
+        if (group <= 1)
+        {
+            return index;
+        }
+        const unsigned shift = static_cast<unsigned>(group) - 1;
+        const auto mantissa = static_cast<std::uint64_t>((index & (SubBuckets - 1)) | SubBuckets);
+        const std::uint64_t low = mantissa << shift;
+        return low + ((std::uint64_t{ 1 } << shift) >> 1);
+    }
+
+    /**
+     * Add a sample (single writer)
+     */
+    void Record(std::uint64_t value) noexcept
+    {
+        std::atomic<std::uint64_t>& count = m_counts[BucketIndex(value)];
+        count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    /**
+     * Add the samples of another histogram. The histogram merged into
+     * must not be recorded to concurrently.
+     */
+    void Merge(const LatencyHistogram& other) noexcept
+    {
+        for (std::size_t i = 0; i < BucketCount; i++)
+        {
+            const std::uint64_t count = other.m_counts[i].load(std::memory_order_relaxed);
+            if (count != 0)
+            {
+                m_counts[i].store(
+                  m_counts[i].load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    std::uint64_t Count() const noexcept
+    {
+        std::uint64_t total = 0;
+        for (const auto& count : m_counts)
+        {
+            total += count.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    /**
+     * Smallest recorded value, such that a fraction of the samples
+     * are less than or equal to it
+     *
+     * @param fraction - in [0, 1], e.g. 0.99 for the 99th percentile
+     * @return Value or zero if the histogram is empty
+     */
+    std::uint64_t ValueAtFraction(double fraction) const noexcept
+    {
+        const std::uint64_t total = Count();
+        if (total == 0)
+        {
+            return 0;
+        }
+        const auto rank =
+          static_cast<std::uint64_t>(std::ceil(fraction * static_cast<double>(total)));
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < BucketCount; i++)
+        {
+            seen += m_counts[i].load(std::memory_order_relaxed);
+            if (seen >= rank && seen != 0)
+            {
+                return BucketValue(i);
+            }
+        }
+        return BucketValue(BucketCount - 1);
+    }
+
+    /**
+     * Percentiles of values recorded in @ref Clock ticks
+     */
+    LatencyPercentiles Percentiles() const noexcept
+    {
+        LatencyPercentiles percentiles;
+        percentiles.count = Count();
+        percentiles.p50 = Clock::ToDuration(ValueAtFraction(0.5));
+        percentiles.p99 = Clock::ToDuration(ValueAtFraction(0.99));
+        percentiles.p999 = Clock::ToDuration(ValueAtFraction(0.999));
+        return percentiles;
+    }
+
+  private:
+    std::array<std::atomic<std::uint64_t>, BucketCount> m_counts{};
+};
+
+//! TaskLatency
+/*!
+  Histograms of the time tasks spend queued and executing, in @ref
+  Clock ticks
+ */
+struct TaskLatency
+{
+    LatencyHistogram queueDelay;
+    LatencyHistogram runTime;
+
+    void Merge(const TaskLatency& other) noexcept
+    {
+        queueDelay.Merge(other.queueDelay);
+        runTime.Merge(other.runTime);
+    }
+};
+
+} // namespace detail::v20
+
+//! LatencyStats
+/*!
+  Percentiles of the queue delay, from submission until execution
+  starts, and of the run time of tasks
+ */
+struct LatencyStats
+{
+    LatencyPercentiles queueDelay;
+    LatencyPercentiles runTime;
+};
+
+using LatencyHistogram = detail::v20::LatencyHistogram;
+using TaskLatency = detail::v20::TaskLatency;
+} // namespace PBB
@@ -34,14 +34,21 @@
 #error "This header requires at least C++20"
 #endif
 
+#include <array>
 #include <atomic>
+#include <chrono>
 #include <concepts>
-#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <mutex>
-#include <queue>
 #include <utility>
 
+#include <PBB/Probes.hpp>
+#include <PBB/ProfiledMutex.hpp>
+#include <PBB/QueueStats.hpp>
+#include <PBB/SegmentedQueue.hpp>
+
 namespace PBB
 {
 namespace detail::v20
@@ -77,8 +84,7 @@ class IMRMWQueue
     virtual void Clear() = 0;
     virtual bool Empty() const = 0;
 
-    bool Push(
-      const T& souce) noexcept requires CopyConstructibleType<T> && NoThrowCopyConstructible<T>;
+    bool Push(const T& souce) requires CopyConstructibleType<T> && NoThrowCopyConstructible<T>;
 
   protected:
     IMRMWQueue() noexcept = default;
@@ -88,10 +94,38 @@ class IMRMWQueue
     IMRMWQueue& operator=(const IMRMWQueue&) = delete;
 };
 
-template <typename T>
+//! MRMWQueue
+/*!
+  Blocking multi-reader-multi-writer queue. With more than one lane,
+  each lane is a FIFO and lanes are served in order, lane 0 first.
+  To prevent starvation, a non-empty lane which has been bypassed
+  AgingLimitGet() times is served before any lanes ahead of it.
+
+  Items are stored in fixed-size segments of SegmentSize items, which
+  are recycled through a free list of at most FreeSegmentLimit
+  segments. Segments are allocated before, and deleted after, holding
+  the mutex, such that the critical sections never call the heap. If
+  a segment cannot be allocated, a push throws std::bad_alloc and
+  leaves both the queue and the item unchanged.
+
+  Consumers blocked in Pop() sleep on an atomic push counter (a futex
+  on Linux), while timed consumers wait on a condition variable. Both
+  kinds of sleepers are counted, such that a push only wakes a consumer
+  if one is sleeping, and it does so after releasing the mutex.
+ */
+template <typename T, std::size_t Lanes = 1>
 class MRMWQueue : public IMRMWQueue<T>
 {
+    static_assert(Lanes > 0, "At least one lane is required");
+
   public:
+    static constexpr std::size_t NumLanes = Lanes;
+    static constexpr std::size_t DefaultAgingLimit = 32;
+    static constexpr std::size_t SegmentSize = 64;
+    static constexpr std::size_t FreeSegmentLimit = 16;
+
+    using QueueMutex = Mutex<"MRMWQueue::m_mutex">;
+
     MRMWQueue() noexcept = default;
 
     ~MRMWQueue() noexcept override
@@ -100,117 +134,535 @@ class MRMWQueue : public IMRMWQueue<T>
         Clear();
     }
 
-    std::mutex& GetMutex() noexcept { return m_mutex; }
+    QueueMutex& GetMutex() noexcept { return m_mutex; }
 
     bool TryPop(T& destination) noexcept override
     {
-        std::lock_guard<std::mutex> guard(m_mutex);
-        if (m_queue.empty())
-        {
+        SegmentPtr retired;
+        std::unique_lock<QueueMutex> guard = LockCounted();
+        return PopLocked(destination, retired);
+    }
+
+    bool Pop(T& destination) override
+    {
+        if (!m_valid.load(std::memory_order_acquire))
             return false;
+
+        SegmentPtr retired;
+        for (;;)
+        {
+            std::uint32_t pushes = 0;
+            {
+                std::unique_lock<QueueMutex> guard = LockCounted();
+                if (!m_valid.load(std::memory_order_acquire))
+                    return false;
+                if (CanPopLocked())
+                    return PopLocked(destination, retired);
+
+                // Register while holding the mutex, such that a push
+                // after releasing it sees the sleeper
+                pushes = m_pushes.load(std::memory_order_relaxed);
+                m_sleepers.fetch_add(1, std::memory_order_relaxed);
+            }
+            const auto waitStart = m_counters.WaitBegin();
+            PBB_PROBE2(queue_block, this, 0);
+            m_pushes.wait(pushes, std::memory_order_acquire);
+            PBB_PROBE2(queue_unblock, this, 0);
+            m_counters.WaitEnd(waitStart);
+            m_sleepers.fetch_sub(1, std::memory_order_relaxed);
         }
-        destination = std::move(m_queue.front());
-        m_queue.pop();
-        return true;
     }
 
-    bool Pop(T& destination) override
+    /**
+     * Pop, waiting at most a given duration for an item. A push wakes
+     * either a timed or an untimed consumer.
+     *
+     * @param destination - item
+     * @param timeout - maximum time to wait
+     * @return False on timeout or if the queue was invalidated
+     */
+    template <typename Rep, typename Period>
+    bool PopFor(T& destination, const std::chrono::duration<Rep, Period>& timeout)
+    {
+        return PopUntil(destination, DeadlineAfter(timeout));
+    }
+
+    /**
+     * Pop, waiting until a deadline for an item
+     *
+     * @param destination - item
+     * @param deadline - time point after which to give up
+     * @return False on timeout or if the queue was invalidated
+     */
+    template <typename Clock, typename Duration>
+    bool PopUntil(T& destination, const std::chrono::time_point<Clock, Duration>& deadline)
     {
         if (!m_valid.load(std::memory_order_acquire))
             return false;
 
-        std::unique_lock<std::mutex> lock{ m_mutex };
-        m_condition.wait(
-          lock, [this]() { return !m_queue.empty() || !m_valid.load(std::memory_order_acquire); });
+        SegmentPtr retired;
+        std::unique_lock<QueueMutex> lock = LockCounted();
+        // Registered and unregistered while holding the mutex
+        m_timedSleepers.store(
+          m_timedSleepers.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        const auto waitStart = m_counters.WaitBegin();
+        PBB_PROBE2(queue_block, this, 0);
+        const bool ready =
+          m_condition.wait_until(lock, deadline, [this]() { return CanPopLocked(); });
+        PBB_PROBE2(queue_unblock, this, 0);
+        m_counters.WaitEnd(waitStart);
+        m_timedSleepers.store(
+          m_timedSleepers.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+        if (!ready)
+            return false;
 
         if (!m_valid.load(std::memory_order_acquire))
             return false;
 
-        if (m_queue.empty())
+        return PopLocked(destination, retired);
+    }
+
+    bool Push(T&& source) override { return Push(std::move(source), 0); }
+
+    /**
+     * Push to a given lane. If the queue is bounded and full, wait
+     * until there is room.
+     *
+     * @param source - item, not consumed if the push fails
+     * @param lane - lane in [0, NumLanes), lower lanes are served first
+     * @return False if the queue is closed or was invalidated while waiting for room
+     */
+    bool Push(T&& source, std::size_t lane)
+    {
+        SegmentPtr spare = SpareSegment();
         {
-            return false;
+            std::unique_lock<QueueMutex> lock = LockCounted();
+            if (ClosedLocked() || !WaitNotFull(lock))
+            {
+                return false;
+            }
+            PushLocked(std::move(source), lane, spare);
         }
+        WakeConsumer();
+        return true;
+    }
 
-        destination = std::move(m_queue.front());
-        m_queue.pop();
+    bool Push(const T& source) requires CopyConstructibleType<T> && NoThrowCopyConstructible<T>
+    {
+        SegmentPtr spare = SpareSegment();
+        {
+            std::unique_lock<QueueMutex> lock = this->LockCounted();
+            if (this->ClosedLocked() || !this->WaitNotFull(lock))
+            {
+                return false;
+            }
+            this->PushLocked(source, 0, spare);
+        }
+        this->WakeConsumer();
         return true;
     }
 
-    bool Push(T&& source) noexcept override
+    /**
+     * Push without waiting
+     *
+     * @param source - item, not consumed if the push fails
+     * @param lane - lane in [0, NumLanes)
+     * @return False if the queue is full or closed
+     */
+    bool TryPush(T&& source, std::size_t lane = 0)
     {
-        std::lock_guard<std::mutex> guard(m_mutex);
-        m_queue.push(std::move(source));
-        m_condition.notify_one();
+        SegmentPtr spare = SpareSegment();
+        {
+            std::unique_lock<QueueMutex> guard = LockCounted();
+            if (ClosedLocked() || FullLocked())
+            {
+                return false;
+            }
+            PushLocked(std::move(source), lane, spare);
+        }
+        WakeConsumer();
         return true;
     }
 
-    bool Push(
-      const T& source) noexcept requires CopyConstructibleType<T> && NoThrowCopyConstructible<T>
+    /**
+     * Push, waiting until a deadline for room if the queue is full
+     *
+     * @param source - item, not consumed if the push fails
+     * @param deadline - time point after which to give up
+     * @param lane - lane in [0, NumLanes)
+     * @return False if the queue is still full at the deadline or was invalidated
+     */
+    template <typename Clock, typename Duration>
+    bool TryPushUntil(T&& source, const std::chrono::time_point<Clock, Duration>& deadline,
+      std::size_t lane = 0)
     {
-        std::lock_guard<std::mutex> guard(this->m_mutex);
-        this->m_queue.push(source);
-        this->m_condition.notify_one();
+        SegmentPtr spare = SpareSegment();
+        {
+            std::unique_lock<QueueMutex> lock = LockCounted();
+            if (!CanPushLocked())
+            {
+                PBB_PROBE2(queue_block, this, 1);
+                m_notFull.wait_until(lock, deadline, [this]() { return CanPushLocked(); });
+                PBB_PROBE2(queue_unblock, this, 1);
+            }
+            if (!CanPushLocked() || !m_valid.load(std::memory_order_acquire) || ClosedLocked())
+            {
+                return false;
+            }
+            PushLocked(std::move(source), lane, spare);
+        }
+        WakeConsumer();
         return true;
     }
 
+    /**
+     * Push, waiting at most a given duration for room if the queue is full
+     *
+     * @param source - item, not consumed if the push fails
+     * @param timeout - maximum time to wait
+     * @param lane - lane in [0, NumLanes)
+     * @return False if the queue is still full after the timeout or was invalidated
+     */
+    template <typename Rep, typename Period>
+    bool TryPushFor(T&& source, const std::chrono::duration<Rep, Period>& timeout,
+      std::size_t lane = 0)
+    {
+        return TryPushUntil(std::move(source), DeadlineAfter(timeout), lane);
+    }
+
+    /**
+     * Maximum number of queued items. Zero (default) means unbounded.
+     */
+    void CapacitySet(std::size_t capacity) noexcept
+    {
+        std::lock_guard<QueueMutex> guard{ m_mutex };
+        m_capacity = capacity;
+        m_notFull.notify_all();
+    }
+
+    std::size_t CapacityGet() const noexcept
+    {
+        std::lock_guard<QueueMutex> guard{ m_mutex };
+        return m_capacity;
+    }
+
+    std::size_t Size() const noexcept
+    {
+        std::lock_guard<QueueMutex> guard{ m_mutex };
+        return m_size;
+    }
+
     void Invalidate() noexcept override
     {
         m_valid.store(false, std::memory_order_release);
-        std::lock_guard<std::mutex> guard{ m_mutex };
-        m_condition.notify_all();
+        WakeAll();
     }
 
     bool Valid() const noexcept override { return m_valid.load(std::memory_order_acquire); }
 
+    /**
+     * Reject further pushes, while consumers drain the remaining items.
+     * Once closed and empty, Pop returns false without waiting. Unlike
+     * Invalidate, items already queued are still handed out.
+     */
+    void Close() noexcept
+    {
+        m_closed.store(true, std::memory_order_release);
+        WakeAll();
+    }
+
+    bool Closed() const noexcept { return m_closed.load(std::memory_order_acquire); }
+
     void Clear() noexcept override
     {
-        std::lock_guard<std::mutex> guard{ m_mutex };
-        while (!m_queue.empty())
+        // Items and segments are destroyed after releasing the mutex
+        std::array<Storage, Lanes> cleared;
+        std::lock_guard<QueueMutex> guard{ m_mutex };
+        for (std::size_t lane = 0; lane < Lanes; lane++)
         {
-            m_queue.pop();
+            cleared[lane] = std::move(m_queues[lane]);
         }
+        m_size = 0;
+        m_skipped.fill(0);
         m_condition.notify_all();
+        m_notFull.notify_all();
     }
 
     bool Empty() const noexcept override
     {
-        std::lock_guard<std::mutex> guard{ m_mutex };
-        return m_queue.empty();
+        std::lock_guard<QueueMutex> guard{ m_mutex };
+        return m_size == 0;
+    }
+
+    /**
+     * Number of times a non-empty lane can be bypassed by lanes ahead
+     * of it, before it is served.
+     */
+    void AgingLimitSet(std::size_t agingLimit) noexcept
+    {
+        std::lock_guard<QueueMutex> guard{ m_mutex };
+        m_agingLimit = agingLimit > 0 ? agingLimit : 1;
+    }
+
+    std::size_t AgingLimitGet() const noexcept
+    {
+        std::lock_guard<QueueMutex> guard{ m_mutex };
+        return m_agingLimit;
+    }
+
+    /**
+     * Snapshot of the queue telemetry. Only the depth is reported,
+     * unless compiled with PBB_ENABLE_STATS.
+     */
+    QueueStats Stats() const noexcept
+    {
+        QueueStats stats;
+        stats.depth = Size();
+        m_counters.Collect(stats);
+        return stats;
     }
 
   protected:
-    std::queue<T> m_queue;      ///< Queue containing e.g. callables
-    mutable std::mutex m_mutex; ///< Mutex for locking
+    using Storage = SegmentedQueue<T, SegmentSize>;
+    using Segment = typename Storage::Segment;
+    using SegmentPtr = detail::v20::SegmentPtr<T, SegmentSize>;
+
+    // Lock on the push and pop paths, counting contention if enabled
+    std::unique_lock<QueueMutex> LockCounted() noexcept
+    {
+        if constexpr (StatsEnabled)
+        {
+            std::unique_lock<QueueMutex> lock{ m_mutex, std::try_to_lock };
+            if (!lock.owns_lock())
+            {
+                m_counters.Contended();
+                lock.lock();
+            }
+            return lock;
+        }
+        else
+        {
+            return std::unique_lock<QueueMutex>{ m_mutex };
+        }
+    }
+
+    // Allocate a segment before locking, unless the free list has one
+    SegmentPtr SpareSegment() const
+    {
+        return SegmentPtr(m_freeSegments.CountHint() == 0 ? new Segment : nullptr);
+    }
+
+    /**
+     * Push while holding the mutex. The spare segment is used if no
+     * segment is free, otherwise it is put on the free list. What
+     * remains in spare must be deleted after releasing the mutex.
+     */
+    template <typename U>
+    void PushLocked(U&& source, std::size_t lane, SegmentPtr& spare)
+    {
+        Storage& queue = m_queues[lane];
+        Segment* pSegment = nullptr;
+        if (queue.NeedsSegment())
+        {
+            pSegment = m_freeSegments.Pop();
+            if (!pSegment)
+            {
+                // Only allocates under the mutex if another push took the free segment
+                pSegment = spare ? spare.release() : new Segment;
+            }
+        }
+        queue.Push(std::forward<U>(source), pSegment);
+        m_size++;
+        m_counters.PushedLocked(m_size);
+        AdvancePushesLocked();
+        if (spare)
+        {
+            spare = m_freeSegments.Push(std::move(spare));
+        }
+    }
+
+    // Only modified while holding the mutex, so no read-modify-write is needed
+    void AdvancePushesLocked() noexcept
+    {
+        m_pushes.store(m_pushes.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Wake one consumer after a push, if any are sleeping. Called after
+    // releasing the mutex, such that the consumer can take it at once.
+    void WakeConsumer() noexcept
+    {
+        if (m_sleepers.load(std::memory_order_relaxed) != 0)
+        {
+            m_pushes.notify_one();
+        }
+        if (m_timedSleepers.load(std::memory_order_relaxed) != 0)
+        {
+            m_condition.notify_one();
+        }
+    }
+
+    // Wake all consumers and producers to re-check the queue state
+    void WakeAll() noexcept
+    {
+        {
+            std::lock_guard<QueueMutex> guard{ m_mutex };
+            AdvancePushesLocked();
+        }
+        m_pushes.notify_all();
+        m_condition.notify_all();
+        m_notFull.notify_all();
+    }
+
+    /**
+     * Pop while holding the mutex. A segment emptied by the pop is put
+     * on the free list, or returned in retired if the list is full.
+     */
+    bool PopLocked(T& destination, SegmentPtr& retired)
+    {
+        const std::size_t lane = SelectLaneLocked();
+        if (lane == Lanes)
+        {
+            return false;
+        }
+        destination = std::move(m_queues[lane].Front());
+        if (SegmentPtr drained = m_queues[lane].Pop())
+        {
+            retired = m_freeSegments.Push(std::move(drained));
+        }
+        m_size--;
+        m_counters.PoppedLocked();
+        if (m_capacity != 0)
+        {
+            m_notFull.notify_one();
+        }
+        return true;
+    }
+
+    bool FullLocked() const noexcept { return m_capacity != 0 && m_size >= m_capacity; }
+
+    // Wait predicates, shared by timed and untimed waits
+    bool ClosedLocked() const noexcept { return m_closed.load(std::memory_order_relaxed); }
+
+    bool CanPopLocked() const noexcept
+    {
+        return m_size != 0 || ClosedLocked() || !m_valid.load(std::memory_order_acquire);
+    }
+
+    bool CanPushLocked() const noexcept
+    {
+        return !FullLocked() || ClosedLocked() || !m_valid.load(std::memory_order_acquire);
+    }
+
+    bool WaitNotFull(std::unique_lock<QueueMutex>& lock) noexcept
+    {
+        if (FullLocked())
+        {
+            PBB_PROBE2(queue_block, this, 1);
+            m_notFull.wait(lock, [this]() { return CanPushLocked(); });
+            PBB_PROBE2(queue_unblock, this, 1);
+            return m_valid.load(std::memory_order_acquire) && !ClosedLocked();
+        }
+        return true;
+    }
+
+    // Saturates instead of overflowing for very long timeouts
+    template <typename Rep, typename Period>
+    static std::chrono::steady_clock::time_point DeadlineAfter(
+      const std::chrono::duration<Rep, Period>& timeout) noexcept
+    {
+        using Clock = std::chrono::steady_clock;
+        const auto now = Clock::now();
+        if (timeout <= std::chrono::duration<Rep, Period>::zero())
+        {
+            return now;
+        }
+        if (std::chrono::duration<double>(timeout) >=
+          std::chrono::duration<double>(Clock::time_point::max() - now))
+        {
+            return Clock::time_point::max();
+        }
+        return now + std::chrono::duration_cast<Clock::duration>(timeout);
+    }
+
+    std::size_t SelectLaneLocked() noexcept
+    {
+        if constexpr (Lanes == 1)
+        {
+            return m_size != 0 ? 0 : Lanes;
+        }
+        else
+        {
+            std::size_t first = 0;
+            while (first < Lanes && m_queues[first].Empty())
+            {
+                first++;
+            }
+            if (first == Lanes)
+            {
+                return Lanes;
+            }
+
+            // Age the lanes bypassed by the first non-empty lane
+            std::size_t selected = first;
+            for (std::size_t lane = first + 1; lane < Lanes; lane++)
+            {
+                if (!m_queues[lane].Empty() && ++m_skipped[lane] > m_agingLimit &&
+                  selected == first)
+                {
+                    selected = lane;
+                }
+            }
+            m_skipped[selected] = 0;
+            return selected;
+        }
+    }
+
+    std::array<Storage, Lanes> m_queues;       ///< Queues containing e.g. callables
+    SegmentFreeList<T, SegmentSize> m_freeSegments{ FreeSegmentLimit };
+    std::size_t m_size{ 0 };                   ///< Total number of items
+    std::array<std::size_t, Lanes> m_skipped{}; ///< Times a lane has been bypassed
+    std::size_t m_agingLimit{ DefaultAgingLimit };
+    std::size_t m_capacity{ 0 }; ///< Maximum number of items, zero for unbounded
+    mutable QueueMutex m_mutex;  ///< Mutex for locking
 
     std::atomic<bool> m_valid{ true };   ///< State for invalidation
-    std::condition_variable m_condition; ///< Condition for signal not empty
+    std::atomic<bool> m_closed{ false }; ///< State for rejecting pushes
+    ConditionVariable m_condition;       ///< Condition for timed waits for not empty
+    ConditionVariable m_notFull;         ///< Condition for signal not full
+
+    // Untimed waits for not empty
+    std::atomic<std::uint32_t> m_pushes{ 0 };   ///< Advanced by every push
+    std::atomic<std::uint32_t> m_sleepers{ 0 }; ///< Consumers waiting on m_pushes
+    std::atomic<std::uint32_t> m_timedSleepers{ 0 }; ///< Consumers waiting on m_condition
+
+    [[no_unique_address]] QueueCounters m_counters; ///< Empty unless PBB_ENABLE_STATS
 };
 
-template <typename T>
+template <typename T, std::size_t Lanes = 1>
 class LockGuard
 {
   public:
-    explicit LockGuard(MRMWQueue<T>& queue) noexcept
+    explicit LockGuard(MRMWQueue<T, Lanes>& queue) noexcept
       : m_queue(queue)
-      , m_lock(queue.get_mutex())
+      , m_lock(queue.GetMutex())
     {
     }
     LockGuard(const LockGuard&) = delete;
     LockGuard& operator=(const LockGuard&) = delete;
 
   private:
-    MRMWQueue<T>& m_queue;
-    std::lock_guard<std::mutex> m_lock;
+    MRMWQueue<T, Lanes>& m_queue;
+    std::lock_guard<typename MRMWQueue<T, Lanes>::QueueMutex> m_lock;
 };
 
 } // namespace detail::v20
 
 template <typename T>
 using IMRMWQueue = detail::v20::IMRMWQueue<T>;
-template <typename T>
-using MRMWQueue = detail::v20::MRMWQueue<T>;
-template <typename T>
-using LockGuard = detail::v20::LockGuard<T>;
+template <typename T, std::size_t Lanes = 1>
+using MRMWQueue = detail::v20::MRMWQueue<T, Lanes>;
+template <typename T, std::size_t Lanes = 1>
+using LockGuard = detail::v20::LockGuard<T, Lanes>;
 } // namespace PBB
 
 /* Local variables: */
@@ -12,19 +12,53 @@
 
 #include <bit>
 #include <cstddef>     // std::byte
+#include <iterator>    // std::random_access_iterator_tag
+#include <limits>      // std::numeric_limits
 #include <memory>      // std::destroy_at, std::launder
-#include <new>         // Placement new
+#include <new>         // Placement new, std::align_val_t
 #include <type_traits> // std::aligned_storage_t
 #include <utility>     // std::forward
+#include <vector>
 
 #if __cplusplus < 201703L
 #error "This header requires at least C++17"
 #endif
 
+#include <PBB/Config.h>
+
 namespace PBB
 {
-// Cache for cache friendly storage
+// Cache line size for cache friendly storage. Probed at configure time
+// (PBB_CACHE_LINE_SIZE), otherwise the destructive interference size
+// of the standard library is used if available.
+#if defined(PBB_CACHE_LINE_SIZE)
+constexpr size_t CACHE_LINE_SIZE = PBB_CACHE_LINE_SIZE;
+#elif defined(__cpp_lib_hardware_interference_size)
+#if defined(__GNUC__) && !defined(__clang__) && (__GNUC__ >= 12)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Winterference-size"
+#endif
+constexpr size_t CACHE_LINE_SIZE = std::hardware_destructive_interference_size;
+#if defined(__GNUC__) && !defined(__clang__) && (__GNUC__ >= 12)
+#pragma GCC diagnostic pop
+#endif
+#else
 constexpr size_t CACHE_LINE_SIZE = 64;
+#endif
+
+// Size of the block fetched by the hardware prefetcher. On x86-64, the
+// adjacent-line prefetcher fetches cache lines in pairs, which makes
+// two lines the real destructive interference size.
+#if defined(PBB_PREFETCH_PAIR_SIZE)
+constexpr size_t PREFETCH_PAIR_SIZE = PBB_PREFETCH_PAIR_SIZE;
+#elif defined(__x86_64__) || defined(_M_X64)
+constexpr size_t PREFETCH_PAIR_SIZE = 2 * CACHE_LINE_SIZE;
+#else
+constexpr size_t PREFETCH_PAIR_SIZE = CACHE_LINE_SIZE;
+#endif
+
+static_assert((CACHE_LINE_SIZE & (CACHE_LINE_SIZE - 1)) == 0, "Invalid cache line size");
+static_assert(PREFETCH_PAIR_SIZE % CACHE_LINE_SIZE == 0, "Invalid prefetch pair size");
 
 // Explicit padding approach - expensive due to explicit padding
 template <typename T>
@@ -35,16 +69,19 @@ struct alignas(CACHE_LINE_SIZE) CacheAlignedStorage
   char padding[CACHE_LINE_SIZE - (sizeof(T) % CACHE_LINE_SIZE)] = {};
 };
 
+// CacheAlignedPlacement is aligned and padded to PREFETCH_PAIR_SIZE, such
+// that the hardware prefetcher does not pull in a neighbouring object.
+
 // ----------------- C++17 Version (Uses std::aligned_storage_t) -----------------
 namespace detail::v17
 {
 template <typename T>
-struct alignas(CACHE_LINE_SIZE) CacheAlignedPlacement
+struct alignas(PREFETCH_PAIR_SIZE) CacheAlignedPlacement
 {
   static constexpr size_t TotalSize =
-    ((sizeof(T) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE) * CACHE_LINE_SIZE;
+    ((sizeof(T) + PREFETCH_PAIR_SIZE - 1) / PREFETCH_PAIR_SIZE) * PREFETCH_PAIR_SIZE;
 
-  alignas(CACHE_LINE_SIZE) std::aligned_storage_t<TotalSize, CACHE_LINE_SIZE> storage;
+  alignas(PREFETCH_PAIR_SIZE) std::aligned_storage_t<TotalSize, PREFETCH_PAIR_SIZE> storage;
 
   template <typename... Args>
   explicit CacheAlignedPlacement(Args&&... args)
@@ -66,14 +103,14 @@ struct alignas(CACHE_LINE_SIZE) CacheAlignedPlacement
 namespace detail::v20
 {
 template <typename T, bool IsNoThrow = std::is_nothrow_constructible_v<T>>
-struct alignas(CACHE_LINE_SIZE) CacheAlignedPlacement;
+struct alignas(PREFETCH_PAIR_SIZE) CacheAlignedPlacement;
 
 template <typename T>
-struct alignas(CACHE_LINE_SIZE) CacheAlignedPlacement<T, true>
+struct alignas(PREFETCH_PAIR_SIZE) CacheAlignedPlacement<T, true>
 {
 private:
   static constexpr size_t TotalSize =
-    ((sizeof(T) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE) * CACHE_LINE_SIZE;
+    ((sizeof(T) + PREFETCH_PAIR_SIZE - 1) / PREFETCH_PAIR_SIZE) * PREFETCH_PAIR_SIZE;
 
   struct Data
   {
@@ -109,13 +146,13 @@ public:
 
 // Specialization when `T` **is NOT** `nothrow_constructible` (Includes `std::byte initialized`)
 template <typename T>
-struct alignas(CACHE_LINE_SIZE) CacheAlignedPlacement<T, false>
+struct alignas(PREFETCH_PAIR_SIZE) CacheAlignedPlacement<T, false>
 {
 private:
   static constexpr size_t TotalSize =
-    ((sizeof(T) + 1 + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE) * CACHE_LINE_SIZE;
+    ((sizeof(T) + 1 + PREFETCH_PAIR_SIZE - 1) / PREFETCH_PAIR_SIZE) * PREFETCH_PAIR_SIZE;
 
-  // We have to use std::byte to not infer an extra CACHE_LINE_SIZE alignment
+  // We have to use std::byte to not infer an extra PREFETCH_PAIR_SIZE alignment
   struct Data
   {
     std::byte storage[TotalSize - 1]; // Use all but the last byte
@@ -127,11 +164,16 @@ private:
   Data data;
 
 public:
-  CacheAlignedPlacement() { construct(); }
+  CacheAlignedPlacement()
+  {
+    data.initialized = std::byte{ 0 };
+    construct();
+  }
 
   template <typename... Args>
   explicit CacheAlignedPlacement(Args&&... args)
   {
+    data.initialized = std::byte{ 0 };
     construct(std::forward<Args>(args)...);
   }
 
@@ -180,6 +222,187 @@ using CacheAlignedPlacement = detail::v17::CacheAlignedPlacement<T>;
 template <typename T>
 using CacheAlignedPlacement = detail::CacheAlignedPlacement<T>;
 
+//! CacheAlignedAllocator
+/*! STL-compatible allocator, which aligns every allocation to Align
+    bytes. Usable with std::vector and friends to ensure that the
+    storage does not share a cache line with other data.
+ */
+template <typename T, std::size_t Align = CACHE_LINE_SIZE>
+class CacheAlignedAllocator
+{
+public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using propagate_on_container_move_assignment = std::true_type;
+  using is_always_equal = std::true_type;
+
+  static constexpr std::size_t Alignment = Align < alignof(T) ? alignof(T) : Align;
+  static_assert((Align & (Align - 1)) == 0, "Alignment must be a power of two");
+
+  template <typename U>
+  struct rebind
+  {
+    using other = CacheAlignedAllocator<U, Align>;
+  };
+
+  CacheAlignedAllocator() noexcept = default;
+
+  template <typename U>
+  CacheAlignedAllocator(const CacheAlignedAllocator<U, Align>&) noexcept
+  {
+  }
+
+  T* allocate(std::size_t n)
+  {
+    if (n > std::numeric_limits<std::size_t>::max() / sizeof(T))
+    {
+      throw std::bad_array_new_length();
+    }
+    return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+  }
+
+  void deallocate(T* p, std::size_t n) noexcept
+  {
+    ::operator delete(p, n * sizeof(T), std::align_val_t(Alignment));
+  }
+
+  template <typename U>
+  bool operator==(const CacheAlignedAllocator<U, Align>&) const noexcept
+  {
+    return true;
+  }
+
+  template <typename U>
+  bool operator!=(const CacheAlignedAllocator<U, Align>&) const noexcept
+  {
+    return false;
+  }
+};
+
+//! CacheAlignedArray
+/*! Fixed-size array, where every element is padded to its own cache
+    line(s). Intended for per-worker partial results and counters,
+    e.g. sized using ThreadPool::NThreadsGet() and indexed using
+    ThreadPool::WorkerIndexGet(), such that workers never false-share.
+ */
+template <typename T, std::size_t Align = CACHE_LINE_SIZE>
+class CacheAlignedArray
+{
+private:
+  struct alignas(Align) Slot
+  {
+    T value;
+  };
+  static_assert(sizeof(Slot) % Align == 0, "Padding issue detected!");
+
+  std::vector<Slot, CacheAlignedAllocator<Slot, Align>> m_slots;
+
+  template <bool IsConst>
+  class BasicIterator
+  {
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<IsConst, const T*, T*>;
+    using reference = std::conditional_t<IsConst, const T&, T&>;
+    using SlotPointer = std::conditional_t<IsConst, const Slot*, Slot*>;
+
+    BasicIterator() = default;
+    explicit BasicIterator(SlotPointer pSlot)
+      : m_pSlot(pSlot)
+    {
+    }
+
+    reference operator*() const { return m_pSlot->value; }
+    pointer operator->() const { return &m_pSlot->value; }
+    reference operator[](difference_type n) const { return m_pSlot[n].value; }
+
+    BasicIterator& operator++()
+    {
+      ++m_pSlot;
+      return *this;
+    }
+    BasicIterator operator++(int)
+    {
+      BasicIterator tmp = *this;
+      ++m_pSlot;
+      return tmp;
+    }
+    BasicIterator& operator--()
+    {
+      --m_pSlot;
+      return *this;
+    }
+    BasicIterator operator--(int)
+    {
+      BasicIterator tmp = *this;
+      --m_pSlot;
+      return tmp;
+    }
+    BasicIterator& operator+=(difference_type n)
+    {
+      m_pSlot += n;
+      return *this;
+    }
+    BasicIterator& operator-=(difference_type n)
+    {
+      m_pSlot -= n;
+      return *this;
+    }
+    BasicIterator operator+(difference_type n) const { return BasicIterator(m_pSlot + n); }
+    friend BasicIterator operator+(difference_type n, const BasicIterator& it)
+    {
+      return BasicIterator(it.m_pSlot + n);
+    }
+    BasicIterator operator-(difference_type n) const { return BasicIterator(m_pSlot - n); }
+    difference_type operator-(const BasicIterator& rhs) const { return m_pSlot - rhs.m_pSlot; }
+
+    bool operator==(const BasicIterator& rhs) const { return m_pSlot == rhs.m_pSlot; }
+    bool operator!=(const BasicIterator& rhs) const { return m_pSlot != rhs.m_pSlot; }
+    bool operator<(const BasicIterator& rhs) const { return m_pSlot < rhs.m_pSlot; }
+    bool operator>(const BasicIterator& rhs) const { return m_pSlot > rhs.m_pSlot; }
+    bool operator<=(const BasicIterator& rhs) const { return m_pSlot <= rhs.m_pSlot; }
+    bool operator>=(const BasicIterator& rhs) const { return m_pSlot >= rhs.m_pSlot; }
+
+  private:
+    SlotPointer m_pSlot = nullptr;
+  };
+
+public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using iterator = BasicIterator<false>;
+  using const_iterator = BasicIterator<true>;
+
+  explicit CacheAlignedArray(std::size_t count)
+    : m_slots(count)
+  {
+  }
+
+  CacheAlignedArray(std::size_t count, const T& value)
+    : m_slots(count, Slot{ value })
+  {
+  }
+
+  T& operator[](std::size_t index) { return m_slots[index].value; }
+  const T& operator[](std::size_t index) const { return m_slots[index].value; }
+
+  std::size_t size() const noexcept { return m_slots.size(); }
+  bool empty() const noexcept { return m_slots.empty(); }
+
+  iterator begin() noexcept { return iterator(m_slots.data()); }
+  iterator end() noexcept { return iterator(m_slots.data() + m_slots.size()); }
+  const_iterator begin() const noexcept { return const_iterator(m_slots.data()); }
+  const_iterator end() const noexcept { return const_iterator(m_slots.data() + m_slots.size()); }
+};
+
+#if __cplusplus >= 202002L
+static_assert(std::random_access_iterator<CacheAlignedArray<int>::iterator>);
+static_assert(std::random_access_iterator<CacheAlignedArray<int>::const_iterator>);
+#endif
+
 // Type trait to determine the underlying type
 template <typename T>
 struct UnderlyingType
@@ -203,4 +426,23 @@ struct UnderlyingType<CacheAlignedPlacement<T>>
 template <typename T>
 using UnderlyingTypeT = typename UnderlyingType<T>::type;
 
+// Access the underlying value of a (possibly) cache-aligned type
+template <typename T>
+T& UnderlyingValue(T& value)
+{
+  return value;
+}
+
+template <typename T>
+T& UnderlyingValue(CacheAlignedStorage<T>& storage)
+{
+  return storage.value;
+}
+
+template <typename T>
+T& UnderlyingValue(CacheAlignedPlacement<T>& placement)
+{
+  return placement.get();
+}
+
 } // namespace sps
@@ -0,0 +1,93 @@
+/**
+ * @file   Numa.hpp
+ * @author Jens Munk Hansen <jens.munk.hansen@gmail.com>
+ * @date   Mon Oct 19 10:12:41 AM CEST 2026
+ *
+ * @brief  Allocation of memory local to the NUMA node of the calling thread
+ *
+ * Copyright 2025 Jens Munk Hansen
+ *
+ */
+#pragma once
+
+#if __cplusplus < 201703L
+#error "This header requires at least C++17"
+#endif
+
+#include <PBB/Config.h>
+
+#include <cstddef> // std::size_t
+#include <new>     // std::align_val_t
+
+#ifdef PBB_USE_NUMA
+#include <numa.h>
+#endif
+
+namespace PBB::Numa
+{
+/**
+ * Is NUMA policy support available at runtime
+ *
+ */
+inline bool Available() noexcept
+{
+#ifdef PBB_USE_NUMA
+    static const bool available = numa_available() >= 0;
+    return available;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Allocate memory on the NUMA node of the calling thread.
+ *
+ * Using libnuma, memory is allocated using numa_alloc_local, which
+ * binds whole pages to the local node. Every allocation is an mmap
+ * system call and occupies at least one page (typically 4 KiB), no
+ * matter how small size is. Otherwise, we rely on the
+ * first-touch policy of the operating system, i.e. memory is placed
+ * on the node of the thread that first writes to it, which is the
+ * calling thread when the object is constructed in place afterwards.
+ *
+ * @param size - number of bytes
+ * @param alignment - alignment (honored by both strategies)
+ *
+ * @return Pointer to uninitialized memory
+ */
+inline void* AllocateLocal(std::size_t size, std::size_t alignment)
+{
+#ifdef PBB_USE_NUMA
+    if (Available())
+    {
+        // Page aligned, which satisfies any cache alignment
+        void* memory = numa_alloc_local(size);
+        if (!memory)
+        {
+            throw std::bad_alloc();
+        }
+        return memory;
+    }
+#endif
+    return ::operator new(size, std::align_val_t(alignment));
+}
+
+/**
+ * Release memory obtained using @ref AllocateLocal
+ *
+ * @param memory - pointer returned by AllocateLocal
+ * @param size - size given to AllocateLocal
+ * @param alignment - alignment given to AllocateLocal
+ */
+inline void DeallocateLocal(void* memory, std::size_t size, std::size_t alignment) noexcept
+{
+#ifdef PBB_USE_NUMA
+    if (Available())
+    {
+        numa_free(memory, size);
+        return;
+    }
+#endif
+    ::operator delete(memory, size, std::align_val_t(alignment));
+}
+} // namespace PBB::Numa
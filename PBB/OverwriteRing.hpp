@@ -0,0 +1,256 @@
+/**
+ * @file   OverwriteRing.hpp
+ * @author Jens Munk Hansen <jens.munk.hansen@gmail.com>
+ * @date   Mon Oct 19 15:21:40 CEST 2026
+ *
+ * @brief  Lock-free overwriting ring buffer holding the latest N items
+ *
+ * Copyright 2025 Jens Munk Hansen
+ *
+ */
+#pragma once
+
+#if __cplusplus < 202002L
+#error "This header requires at least C++20"
+#endif
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include <PBB/Common.hpp>
+#include <PBB/Memory.hpp>
+
+namespace PBB
+{
+namespace detail::v20
+{
+//! OverwriteRing
+/*!
+  Ring buffer keeping the latest Capacity() items written by a single
+  producer. The producer never waits: when the ring is full, the oldest
+  item is overwritten. Any number of readers, each with its own @ref
+  Reader, read concurrently without locks. A read is validated using
+  the sequence number of the slot (seqlock), and retried if the slot
+  was overwritten meanwhile. Items overwritten before a reader got to
+  them are counted as missed.
+
+  Items are stored as atomic words, such that concurrent reads and
+  writes are well-defined. No memory is allocated after construction.
+ */
+template <typename T>
+requires std::is_trivially_copyable_v<T>
+class OverwriteRing
+{
+  public:
+    //! Reader
+    /*!
+      Position and statistics of a single reader. A reader must only
+      be used by one thread at a time.
+     */
+    class Reader
+    {
+      public:
+        /**
+         * Number of items overwritten before this reader read them
+         */
+        std::uint64_t Missed() const noexcept { return m_missed; }
+
+        /**
+         * Number of items read or missed so far
+         */
+        std::uint64_t Position() const noexcept { return m_cursor; }
+
+      private:
+        friend class OverwriteRing;
+        explicit Reader(std::uint64_t cursor) noexcept
+          : m_cursor(cursor)
+        {
+        }
+        std::uint64_t m_cursor;
+        std::uint64_t m_missed{ 0 };
+    };
+
+    /**
+     * Constructor
+     *
+     * @param capacity - number of items kept, rounded up to a power of two
+     */
+    explicit OverwriteRing(std::size_t capacity)
+      : m_slots(std::bit_ceil(std::max<std::size_t>(capacity, 1)))
+      , m_mask(m_slots.size() - 1)
+    {
+    }
+    PBB_DELETE_COPY_CTORS(OverwriteRing);
+
+    std::size_t Capacity() const noexcept { return m_mask + 1; }
+
+    /**
+     * Write an item, overwriting the oldest one if the ring is full.
+     * Must only be called by a single producer thread.
+     */
+    void Push(const T& item) noexcept
+    {
+        const std::uint64_t position = m_written;
+        Slot& slot = m_slots[position & m_mask];
+
+        // Odd while writing
+        slot.sequence.store(2 * position + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        Words words{};
+        std::memcpy(words.data(), &item, sizeof(T));
+        for (std::size_t i = 0; i < NWords; i++)
+        {
+            slot.data[i].store(words[i], std::memory_order_relaxed);
+        }
+
+        slot.sequence.store(2 * position + 2, std::memory_order_release);
+        m_written = position + 1;
+        m_published.store(position + 1, std::memory_order_release);
+    }
+
+    /**
+     * Create a reader
+     *
+     * @param fromOldest - start at the oldest item kept, otherwise
+     *                     only items pushed from now on are read
+     */
+    Reader CreateReader(bool fromOldest = false) const noexcept
+    {
+        const std::uint64_t published = m_published.load(std::memory_order_acquire);
+        if (fromOldest)
+        {
+            return Reader(published > Capacity() ? published - Capacity() : 0);
+        }
+        return Reader(published);
+    }
+
+    /**
+     * Read the next item of a reader. Items overwritten since the last
+     * read are skipped and counted as missed.
+     *
+     * @param reader - reader
+     * @param destination - item
+     * @return False if the reader has read all items published
+     */
+    bool TryRead(Reader& reader, T& destination) const noexcept
+    {
+        for (;;)
+        {
+            const std::uint64_t published = m_published.load(std::memory_order_acquire);
+            if (reader.m_cursor >= published)
+            {
+                return false;
+            }
+            SkipOverwritten(reader, published);
+            if (ReadSlot(reader.m_cursor, destination))
+            {
+                reader.m_cursor++;
+                return true;
+            }
+            // Overwritten while reading, retry with a newer position
+        }
+    }
+
+    /**
+     * Read the most recent item, skipping (and counting as missed) any
+     * items published before it, which the reader has not read.
+     *
+     * @param reader - reader
+     * @param destination - item
+     * @return False if no item newer than the last read is published
+     */
+    bool TryReadLatest(Reader& reader, T& destination) const noexcept
+    {
+        for (;;)
+        {
+            const std::uint64_t published = m_published.load(std::memory_order_acquire);
+            if (reader.m_cursor >= published)
+            {
+                return false;
+            }
+            reader.m_missed += published - 1 - reader.m_cursor;
+            reader.m_cursor = published - 1;
+            if (ReadSlot(reader.m_cursor, destination))
+            {
+                reader.m_cursor++;
+                return true;
+            }
+        }
+    }
+
+    /**
+     * Number of items pushed in total
+     */
+    std::uint64_t Published() const noexcept
+    {
+        return m_published.load(std::memory_order_acquire);
+    }
+
+  private:
+    static constexpr std::size_t NWords =
+      (sizeof(T) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+    using Words = std::array<std::uint64_t, NWords>;
+
+    struct alignas(CACHE_LINE_SIZE) Slot
+    {
+        std::atomic<std::uint64_t> sequence{ 0 };
+        std::array<std::atomic<std::uint64_t>, NWords> data{};
+    };
+
+    void SkipOverwritten(Reader& reader, std::uint64_t published) const noexcept
+    {
+        // The oldest slot may be overwritten by a push in progress, in
+        // which case reading it fails and is retried once published
+        if (published - reader.m_cursor > Capacity())
+        {
+            const std::uint64_t oldest = published - Capacity();
+            reader.m_missed += oldest - reader.m_cursor;
+            reader.m_cursor = oldest;
+        }
+    }
+
+    bool ReadSlot(std::uint64_t position, T& destination) const noexcept
+    {
+        const Slot& slot = m_slots[position & m_mask];
+        const std::uint64_t expected = 2 * position + 2;
+        if (slot.sequence.load(std::memory_order_acquire) != expected)
+        {
+            return false;
+        }
+
+        Words words;
+        for (std::size_t i = 0; i < NWords; i++)
+        {
+            words[i] = slot.data[i].load(std::memory_order_relaxed);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != expected)
+        {
+            return false;
+        }
+        std::memcpy(&destination, words.data(), sizeof(T));
+        return true;
+    }
+
+    std::vector<Slot> m_slots;
+    const std::size_t m_mask;
+
+    // Producer
+    alignas(PREFETCH_PAIR_SIZE) std::uint64_t m_written{ 0 };
+    std::atomic<std::uint64_t> m_published{ 0 };
+};
+
+} // namespace detail::v20
+
+template <typename T>
+using OverwriteRing = detail::v20::OverwriteRing<T>;
+} // namespace PBB
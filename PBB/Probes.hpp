@@ -0,0 +1,60 @@
+/**
+ * @file   Probes.hpp
+ * @author Jens Munk Hansen <jens.munk.hansen@gmail.com>
+ * @date   Wed Oct 21 14:37:09 CEST 2026
+ *
+ * @brief  USDT (SystemTap SDT) probes for perf, bpftrace and friends
+ *
+ * Copyright 2025 Jens Munk Hansen
+ *
+ */
+#pragma once
+
+#if __cplusplus < 202002L
+#error "This header requires at least C++20"
+#endif
+
+#include <PBB/Config.h>
+
+/*
+  Probes of provider "pbb", enabled by PBB_ENABLE_USDT. A probe is a
+  single NOP and a note in the ELF section .note.stapsdt, which tools
+  use to patch in a breakpoint while attached, e.g.
+
+    bpftrace -e 'usdt:./app:pbb:task_start { @[tid] = count(); }'
+
+  Arguments are integers or pointers. List the probes of a binary with
+  `readelf -n` or `bpftrace -l 'usdt:./app:*'`.
+
+  Probe                 Arguments
+  task_submit           task, init key, lane
+  task_rejected         task, init key, rejection policy
+  task_dequeue          task, init key, worker index
+  task_start            task, init key, worker index
+  task_end              task, init key, worker index
+  init_start            init key, worker index
+  init_end              init key, worker index, succeeded
+  queue_block           queue, 0 for a consumer or 1 for a producer
+  queue_unblock         queue, 0 for a consumer or 1 for a producer
+ */
+#if defined(PBB_ENABLE_USDT) && defined(__linux__)
+#include <sys/sdt.h>
+
+namespace PBB
+{
+inline constexpr bool ProbesEnabled = true;
+}
+
+#define PBB_PROBE1(name, a1) DTRACE_PROBE1(pbb, name, a1)
+#define PBB_PROBE2(name, a1, a2) DTRACE_PROBE2(pbb, name, a1, a2)
+#define PBB_PROBE3(name, a1, a2, a3) DTRACE_PROBE3(pbb, name, a1, a2, a3)
+#else
+namespace PBB
+{
+inline constexpr bool ProbesEnabled = false;
+}
+
+#define PBB_PROBE1(name, a1) ((void)0)
+#define PBB_PROBE2(name, a1, a2) ((void)0)
+#define PBB_PROBE3(name, a1, a2, a3) ((void)0)
+#endif
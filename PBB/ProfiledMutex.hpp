@@ -0,0 +1,433 @@
+/**
+ * @file   ProfiledMutex.hpp
+ * @author Jens Munk Hansen <jens.munk.hansen@gmail.com>
+ * @date   Fri Oct 23 10:14:52 CEST 2026
+ *
+ * @brief  Mutex wrapper measuring contention, wait and hold times
+ *
+ * The internal locks of PBB are declared using the aliases Mutex,
+ * SharedMutex and ConditionVariable, which are the standard types
+ * unless PBB is configured with PBB_PROFILE_LOCKS. Profiled locks are
+ * reported by name using LockProfiles(), e.g.
+ *
+ *   PBB::WriteLockProfiles(std::cout, PBB::LockProfiles());
+ *
+ * Locks, which are not profiled:
+ * - ThreadPool::m_shutdownMutex, m_exitMutex and m_watchdogMutex, and
+ *   Watchdog::m_mutex, taken once per pool, thread exit or sample
+ * - ResettableSingleton::instance_mutex_, taken once per instance
+ * - LockRegistry::m_mutex, guarding the profiles themselves
+ *
+ * Accessors exposing an internal mutex keep returning the standard
+ * type, see NativeMutex(). Locks taken through them are not profiled.
+ *
+ * Copyright 2025 Jens Munk Hansen
+ *
+ */
+#pragma once
+
+#if __cplusplus < 202002L
+#error "This header requires at least C++20"
+#endif
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <shared_mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <PBB/Clock.hpp>
+#include <PBB/Config.h>
+#include <PBB/Memory.hpp>
+
+namespace PBB
+{
+#ifdef PBB_PROFILE_LOCKS
+inline constexpr bool LockProfilingEnabled = true;
+#else
+inline constexpr bool LockProfilingEnabled = false;
+#endif
+
+//! LockProfile
+/*!
+  Counters of all locks sharing a name, e.g. the mutexes of all queues
+ */
+struct LockProfile
+{
+    std::string name;
+    std::uint64_t acquisitions{ 0 }; ///< Exclusive and shared acquisitions
+    std::uint64_t shared{ 0 };       ///< Shared acquisitions
+    std::uint64_t contended{ 0 };    ///< Acquisitions, which had to wait
+    std::chrono::nanoseconds waitTime{ 0 }; ///< Total time waiting to acquire
+    std::chrono::nanoseconds maxWait{ 0 };  ///< Longest single wait
+    std::chrono::nanoseconds holdTime{ 0 }; ///< Total time held exclusively
+};
+
+namespace detail::v20
+{
+//! LockName
+/*!
+  String literal used as a template argument, e.g. Mutex<"Queue">
+ */
+template <std::size_t N>
+struct LockName
+{
+    constexpr LockName(const char (&name)[N]) noexcept { std::copy_n(name, N, value); }
+
+    char value[N];
+};
+
+//! LockSite
+/*!
+  Counters of every lock declared with the same mutex type and name.
+  Counters are striped by thread, such that threads acquiring
+  different instances, e.g. the shards of a queue, do not contend on
+  the counters.
+ */
+class LockSite
+{
+  public:
+    static constexpr std::size_t Stripes = 16;
+
+    explicit LockSite(const char* name) noexcept
+      : m_name(name)
+    {
+    }
+    LockSite(const LockSite&) = delete;
+    LockSite& operator=(const LockSite&) = delete;
+
+    const char* NameGet() const noexcept { return m_name; }
+
+    void Acquired(Clock::Ticks wait, bool contended, bool shared) noexcept
+    {
+        Stripe& stripe = Local();
+        stripe.acquisitions.fetch_add(1, std::memory_order_relaxed);
+        if (shared)
+        {
+            stripe.shared.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (contended)
+        {
+            stripe.contended.fetch_add(1, std::memory_order_relaxed);
+            stripe.waitTicks.fetch_add(wait, std::memory_order_relaxed);
+            Clock::Ticks longest = stripe.maxWaitTicks.load(std::memory_order_relaxed);
+            while (wait > longest &&
+              !stripe.maxWaitTicks.compare_exchange_weak(
+                longest, wait, std::memory_order_relaxed, std::memory_order_relaxed))
+            {
+            }
+        }
+    }
+
+    void Released(Clock::Ticks held) noexcept
+    {
+        Local().holdTicks.fetch_add(held, std::memory_order_relaxed);
+    }
+
+    /**
+     * Add the counters of this site to a profile
+     */
+    void Accumulate(LockProfile& profile) const noexcept
+    {
+        Clock::Ticks wait = 0, maxWait = 0, hold = 0;
+        for (const Stripe& stripe : m_stripes)
+        {
+            profile.acquisitions += stripe.acquisitions.load(std::memory_order_relaxed);
+            profile.shared += stripe.shared.load(std::memory_order_relaxed);
+            profile.contended += stripe.contended.load(std::memory_order_relaxed);
+            wait += stripe.waitTicks.load(std::memory_order_relaxed);
+            maxWait = std::max(maxWait, stripe.maxWaitTicks.load(std::memory_order_relaxed));
+            hold += stripe.holdTicks.load(std::memory_order_relaxed);
+        }
+        profile.waitTime += Clock::ToDuration(wait);
+        profile.maxWait = std::max(profile.maxWait, Clock::ToDuration(maxWait));
+        profile.holdTime += Clock::ToDuration(hold);
+    }
+
+    void Reset() noexcept
+    {
+        for (Stripe& stripe : m_stripes)
+        {
+            stripe.acquisitions.store(0, std::memory_order_relaxed);
+            stripe.shared.store(0, std::memory_order_relaxed);
+            stripe.contended.store(0, std::memory_order_relaxed);
+            stripe.waitTicks.store(0, std::memory_order_relaxed);
+            stripe.maxWaitTicks.store(0, std::memory_order_relaxed);
+            stripe.holdTicks.store(0, std::memory_order_relaxed);
+        }
+    }
+
+  private:
+    struct alignas(CACHE_LINE_SIZE) Stripe
+    {
+        std::atomic<std::uint64_t> acquisitions{ 0 };
+        std::atomic<std::uint64_t> shared{ 0 };
+        std::atomic<std::uint64_t> contended{ 0 };
+        std::atomic<Clock::Ticks> waitTicks{ 0 };
+        std::atomic<Clock::Ticks> maxWaitTicks{ 0 };
+        std::atomic<Clock::Ticks> holdTicks{ 0 };
+    };
+
+    Stripe& Local() noexcept
+    {
+        static std::atomic<std::size_t> threads{ 0 };
+        thread_local const std::size_t index =
+          threads.fetch_add(1, std::memory_order_relaxed) % Stripes;
+        return m_stripes[index];
+    }
+
+    const char* m_name;
+    std::array<Stripe, Stripes> m_stripes;
+};
+
+//! LockRegistry
+/*!
+  Every lock site, which has been used by a profiled lock
+ */
+class LockRegistry
+{
+  public:
+    static LockRegistry& InstanceGet()
+    {
+        // Intentionally leaked, locks may be used during static destruction
+        static LockRegistry* pInstance = new LockRegistry();
+        return *pInstance;
+    }
+
+    LockSite& Add(const char* name)
+    {
+        std::lock_guard<std::mutex> guard{ m_mutex };
+        m_sites.push_back(new LockSite(name));
+        return *m_sites.back();
+    }
+
+    /**
+     * Profiles of all sites merged by name, most waited for first
+     */
+    std::vector<LockProfile> Profiles() const
+    {
+        std::vector<LockProfile> profiles;
+        std::lock_guard<std::mutex> guard{ m_mutex };
+        for (const LockSite* pSite : m_sites)
+        {
+            auto it = std::find_if(profiles.begin(), profiles.end(),
+              [pSite](const LockProfile& profile) { return profile.name == pSite->NameGet(); });
+            if (it == profiles.end())
+            {
+                profiles.push_back(LockProfile{ pSite->NameGet() });
+                it = profiles.end() - 1;
+            }
+            pSite->Accumulate(*it);
+        }
+        std::sort(profiles.begin(), profiles.end(),
+          [](const LockProfile& a, const LockProfile& b) { return a.waitTime > b.waitTime; });
+        return profiles;
+    }
+
+    void Reset()
+    {
+        std::lock_guard<std::mutex> guard{ m_mutex };
+        for (LockSite* pSite : m_sites)
+        {
+            pSite->Reset();
+        }
+    }
+
+  private:
+    LockRegistry() = default;
+
+    mutable std::mutex m_mutex; // Not profiled, only locked when a site is added or reported
+    std::vector<LockSite*> m_sites;
+};
+
+//! ProfiledMutex
+/*!
+  Wrapper of a standard mutex, which counts acquisitions, contended
+  acquisitions and the time spent waiting for and holding the lock. An
+  acquisition is contended if try_lock fails, in which case the
+  blocking lock is timed. Hold times are measured for exclusive locks
+  only, since shared owners cannot be told apart on unlock.
+
+  A ProfiledMutex satisfies the Lockable requirements, and the
+  SharedLockable requirements if Mutex does, so it works with the
+  standard lock types and std::condition_variable_any.
+ */
+template <typename Mutex, LockName Name>
+class ProfiledMutex
+{
+  public:
+    ProfiledMutex()
+      : m_site(Site())
+    {
+    }
+    ProfiledMutex(const ProfiledMutex&) = delete;
+    ProfiledMutex& operator=(const ProfiledMutex&) = delete;
+
+    void lock()
+    {
+        if (m_mutex.try_lock())
+        {
+            m_site.Acquired(0, false, false);
+            m_lockedAt = Clock::Now();
+            return;
+        }
+        const Clock::Ticks start = Clock::Now();
+        m_mutex.lock();
+        m_lockedAt = Clock::Now();
+        m_site.Acquired(m_lockedAt - start, true, false);
+    }
+
+    bool try_lock()
+    {
+        if (!m_mutex.try_lock())
+        {
+            return false;
+        }
+        m_site.Acquired(0, false, false);
+        m_lockedAt = Clock::Now();
+        return true;
+    }
+
+    void unlock()
+    {
+        const Clock::Ticks held = Clock::Now() - m_lockedAt;
+        m_mutex.unlock();
+        m_site.Released(held);
+    }
+
+    void lock_shared()
+    {
+        if (m_mutex.try_lock_shared())
+        {
+            m_site.Acquired(0, false, true);
+            return;
+        }
+        const Clock::Ticks start = Clock::Now();
+        m_mutex.lock_shared();
+        m_site.Acquired(Clock::Now() - start, true, true);
+    }
+
+    bool try_lock_shared()
+    {
+        if (!m_mutex.try_lock_shared())
+        {
+            return false;
+        }
+        m_site.Acquired(0, false, true);
+        return true;
+    }
+
+    void unlock_shared() { m_mutex.unlock_shared(); }
+
+    /**
+     * Wrapped mutex, locks taken directly on it are not profiled
+     */
+    Mutex& NativeGet() noexcept { return m_mutex; }
+
+  private:
+    // One site per mutex type and name, shared by all instances
+    static LockSite& Site()
+    {
+        static LockSite& site = LockRegistry::InstanceGet().Add(Name.value);
+        return site;
+    }
+
+    Mutex m_mutex;
+    LockSite& m_site;
+    Clock::Ticks m_lockedAt{ 0 }; ///< Only accessed by the owner
+};
+} // namespace detail::v20
+
+/**
+ * Mutex of PBB, profiled under the given name if PBB_PROFILE_LOCKS
+ */
+template <detail::v20::LockName Name>
+using Mutex = std::conditional_t<LockProfilingEnabled,
+  detail::v20::ProfiledMutex<std::mutex, Name>, std::mutex>;
+
+template <detail::v20::LockName Name>
+using SharedMutex = std::conditional_t<LockProfilingEnabled,
+  detail::v20::ProfiledMutex<std::shared_mutex, Name>, std::shared_mutex>;
+
+/**
+ * Condition variable waiting on a Mutex
+ */
+using ConditionVariable = std::conditional_t<LockProfilingEnabled, std::condition_variable_any,
+  std::condition_variable>;
+
+/**
+ * Standard mutex of a Mutex, e.g. for exposing an internal lock
+ * through an accessor of a stable type
+ */
+inline std::mutex& NativeMutex(std::mutex& mutex) noexcept
+{
+    return mutex;
+}
+
+template <detail::v20::LockName Name>
+std::mutex& NativeMutex(detail::v20::ProfiledMutex<std::mutex, Name>& mutex) noexcept
+{
+    return mutex.NativeGet();
+}
+
+/**
+ * Profiles of the locks used so far, merged by name and sorted by the
+ * total time spent waiting. Empty unless PBB_PROFILE_LOCKS.
+ */
+inline std::vector<LockProfile> LockProfiles()
+{
+    return detail::v20::LockRegistry::InstanceGet().Profiles();
+}
+
+/**
+ * Reset the counters of all locks, e.g. after a warm-up
+ */
+inline void LockProfilesReset()
+{
+    detail::v20::LockRegistry::InstanceGet().Reset();
+}
+
+/**
+ * Write a row per lock with its acquisitions, the fraction contended,
+ * the total and longest wait, and the total and mean hold time
+ */
+inline void WriteLockProfiles(std::ostream& os, const std::vector<LockProfile>& profiles)
+{
+    const auto microseconds = [](std::chrono::nanoseconds duration)
+    { return std::chrono::duration<double, std::micro>(duration).count(); };
+
+    const std::ios_base::fmtflags flags = os.flags();
+    const std::streamsize precision = os.precision();
+    os << std::left << std::setw(36) << "Lock" << std::right << std::setw(12) << "acquired"
+       << std::setw(10) << "contended" << std::setw(14) << "wait (us)" << std::setw(12)
+       << "max (us)" << std::setw(14) << "hold (us)" << std::setw(12) << "mean (ns)" << '\n';
+    os << std::fixed << std::setprecision(1);
+    for (const LockProfile& profile : profiles)
+    {
+        const std::uint64_t exclusive = profile.acquisitions - profile.shared;
+        const double contended = profile.acquisitions == 0 ? 0.0
+                                                           : 100.0 *
+            static_cast<double>(profile.contended) / static_cast<double>(profile.acquisitions);
+        const double meanHold = exclusive == 0 ? 0.0
+                                               : static_cast<double>(profile.holdTime.count()) /
+            static_cast<double>(exclusive);
+        os << std::left << std::setw(36) << profile.name << std::right << std::setw(12)
+           << profile.acquisitions << std::setw(9) << contended << '%' << std::setw(14)
+           << microseconds(profile.waitTime) << std::setw(12) << microseconds(profile.maxWait)
+           << std::setw(14) << microseconds(profile.holdTime) << std::setw(12) << meanHold
+           << '\n';
+    }
+    os.flags(flags);
+    os.precision(precision);
+}
+
+} // namespace PBB
@@ -0,0 +1,212 @@
+/**
+ * @file   QueueStats.hpp
+ * @author Jens Munk Hansen <jens.munk.hansen@gmail.com>
+ * @date   Tue Oct 20 14:02:17 CEST 2026
+ *
+ * @brief  Compile-time switchable queue telemetry
+ *
+ * Copyright 2025 Jens Munk Hansen
+ *
+ */
+#pragma once
+
+#if __cplusplus < 202002L
+#error "This header requires at least C++20"
+#endif
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include <PBB/Config.h>
+#include <PBB/Memory.hpp>
+
+namespace PBB
+{
+#ifdef PBB_ENABLE_STATS
+inline constexpr bool StatsEnabled = true;
+#else
+inline constexpr bool StatsEnabled = false;
+#endif
+
+namespace detail::v20
+{
+//! QueueStats
+/*!
+  Snapshot of queue telemetry. Only the depth is maintained, unless
+  PBB_ENABLE_STATS is defined.
+ */
+struct QueueStats
+{
+    std::size_t depth{ 0 };                    ///< Items currently queued
+    std::size_t peakDepth{ 0 };                ///< Largest number of items queued
+    std::uint64_t pushes{ 0 };                 ///< Items pushed
+    std::uint64_t pops{ 0 };                   ///< Items popped
+    std::uint64_t contentions{ 0 };            ///< Lock acquisitions finding the mutex taken
+    std::chrono::nanoseconds popWaitTime{ 0 }; ///< Time consumers waited for items
+
+    /**
+     * Accumulate the statistics of another queue, e.g. a shard
+     */
+    QueueStats& operator+=(const QueueStats& other) noexcept
+    {
+        depth += other.depth;
+        peakDepth = peakDepth > other.peakDepth ? peakDepth : other.peakDepth;
+        pushes += other.pushes;
+        pops += other.pops;
+        contentions += other.contentions;
+        popWaitTime += other.popWaitTime;
+        return *this;
+    }
+};
+
+//! QueueCounters
+/*!
+  Relaxed counters behind @ref QueueStats. Without PBB_ENABLE_STATS,
+  the class is empty and every update compiles to nothing.
+
+  The counters start on their own cache lines, away from the state of
+  the owning queue. Contentions and wait times are recorded by any
+  thread, without holding the queue mutex, so they are striped by
+  thread and summed by Collect().
+ */
+class QueueCounters
+{
+  public:
+#ifdef PBB_ENABLE_STATS
+    using TimePoint = std::chrono::steady_clock::time_point;
+#else
+    struct TimePoint
+    {
+    };
+#endif
+
+    /**
+     * Count a push. Called while holding the queue mutex, so no
+     * read-modify-write is needed.
+     *
+     * @param depth - number of items after the push
+     */
+    void PushedLocked([[maybe_unused]] std::size_t depth) noexcept
+    {
+#ifdef PBB_ENABLE_STATS
+        Increment(m_pushes);
+        if (depth > m_peakDepth.load(std::memory_order_relaxed))
+        {
+            m_peakDepth.store(depth, std::memory_order_relaxed);
+        }
+#endif
+    }
+
+    /**
+     * Count a pop. Called while holding the queue mutex.
+     */
+    void PoppedLocked() noexcept
+    {
+#ifdef PBB_ENABLE_STATS
+        Increment(m_pops);
+#endif
+    }
+
+    /**
+     * Raise the peak depth without holding a lock
+     */
+    void RaisePeak([[maybe_unused]] std::size_t depth) noexcept
+    {
+#ifdef PBB_ENABLE_STATS
+        std::size_t peak = m_peakDepth.load(std::memory_order_relaxed);
+        while (depth > peak &&
+          !m_peakDepth.compare_exchange_weak(peak, depth, std::memory_order_relaxed))
+        {
+        }
+#endif
+    }
+
+    /**
+     * Count a lock acquisition which found the mutex taken
+     */
+    void Contended() noexcept
+    {
+#ifdef PBB_ENABLE_STATS
+        Local().contentions.fetch_add(1, std::memory_order_relaxed);
+#endif
+    }
+
+    TimePoint WaitBegin() const noexcept
+    {
+#ifdef PBB_ENABLE_STATS
+        return std::chrono::steady_clock::now();
+#else
+        return {};
+#endif
+    }
+
+    void WaitEnd([[maybe_unused]] TimePoint start) noexcept
+    {
+#ifdef PBB_ENABLE_STATS
+        const auto waited = std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - start);
+        Local().popWaitNs.fetch_add(
+          static_cast<std::uint64_t>(waited.count()), std::memory_order_relaxed);
+#endif
+    }
+
+    /**
+     * Add the counters to a snapshot. The depth is left to the caller.
+     */
+    void Collect([[maybe_unused]] QueueStats& stats) const noexcept
+    {
+#ifdef PBB_ENABLE_STATS
+        QueueStats counted;
+        counted.peakDepth = m_peakDepth.load(std::memory_order_relaxed);
+        counted.pushes = m_pushes.load(std::memory_order_relaxed);
+        counted.pops = m_pops.load(std::memory_order_relaxed);
+        std::uint64_t popWaitNs = 0;
+        for (const Stripe& stripe : m_stripes)
+        {
+            counted.contentions += stripe.contentions.load(std::memory_order_relaxed);
+            popWaitNs += stripe.popWaitNs.load(std::memory_order_relaxed);
+        }
+        counted.popWaitTime = std::chrono::nanoseconds(popWaitNs);
+        stats += counted;
+#endif
+    }
+
+#ifdef PBB_ENABLE_STATS
+  private:
+    static void Increment(std::atomic<std::uint64_t>& counter) noexcept
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    static constexpr std::size_t Stripes = 8;
+
+    struct alignas(CACHE_LINE_SIZE) Stripe
+    {
+        std::atomic<std::uint64_t> contentions{ 0 };
+        std::atomic<std::uint64_t> popWaitNs{ 0 };
+    };
+
+    Stripe& Local() noexcept
+    {
+        static std::atomic<std::size_t> threads{ 0 };
+        thread_local const std::size_t index =
+          threads.fetch_add(1, std::memory_order_relaxed) % Stripes;
+        return m_stripes[index];
+    }
+
+    // Updated while holding the queue mutex
+    alignas(PREFETCH_PAIR_SIZE) std::atomic<std::size_t> m_peakDepth{ 0 };
+    std::atomic<std::uint64_t> m_pushes{ 0 };
+    std::atomic<std::uint64_t> m_pops{ 0 };
+
+    std::array<Stripe, Stripes> m_stripes;
+#endif
+};
+
+} // namespace detail::v20
+
+using QueueStats = detail::v20::QueueStats;
+} // namespace PBB
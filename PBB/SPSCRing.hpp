@@ -0,0 +1,258 @@
+/**
+ * @file   SPSCRing.hpp
+ * @author Jens Munk Hansen <jens.munk.hansen@gmail.com>
+ * @date   Mon Oct 19 14:02:17 CEST 2026
+ *
+ * @brief  Wait-free single-producer-single-consumer (SPSC) ring buffer
+ *
+ * Copyright 2025 Jens Munk Hansen
+ *
+ */
+#pragma once
+
+#if __cplusplus < 202002L
+#error "This header requires at least C++20"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <PBB/Common.hpp>
+#include <PBB/Memory.hpp>
+
+namespace PBB
+{
+namespace detail::v20
+{
+//! SPSCRing
+/*!
+  Fixed-capacity ring buffer for exactly one producer thread and one
+  consumer thread. All operations are wait-free.
+
+  Slots are live objects constructed once, so items are move-assigned
+  in and out. Using Reserve()/Commit() the producer can write an item
+  in place, e.g. reusing the buffers of a large frame, and using
+  Peek()/Consume() the consumer can read it in place.
+
+  Head and tail live on separate cache lines, together with a cached
+  copy of the index owned by the other side, such that the shared
+  indices are only read when the ring appears full or empty.
+ */
+template <typename T>
+requires std::is_default_constructible_v<T> && std::is_move_assignable_v<T>
+class SPSCRing
+{
+  public:
+    /**
+     * Constructor
+     *
+     * @param capacity - minimum capacity, rounded up to a power of two
+     */
+    explicit SPSCRing(std::size_t capacity)
+      : m_slots(std::bit_ceil(std::max<std::size_t>(capacity, 2)))
+      , m_mask(m_slots.size() - 1)
+    {
+    }
+    PBB_DELETE_COPY_CTORS(SPSCRing);
+
+    std::size_t Capacity() const noexcept { return m_mask + 1; }
+
+    // Producer
+
+    bool TryPush(T&& item) noexcept(std::is_nothrow_move_assignable_v<T>)
+    {
+        const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (!HasRoom(tail, 1))
+        {
+            return false;
+        }
+        m_slots[tail & m_mask] = std::move(item);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool TryPush(const T& item) noexcept(std::is_nothrow_copy_assignable_v<T>)
+    requires std::is_copy_assignable_v<T>
+    {
+        const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (!HasRoom(tail, 1))
+        {
+            return false;
+        }
+        m_slots[tail & m_mask] = item;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Move up to count items from a range, publishing them at once
+     *
+     * @param first - iterator to the first item
+     * @param count - number of items available
+     * @return Number of items pushed
+     */
+    template <typename InputIt>
+    std::size_t TryPushBatch(InputIt first, std::size_t count)
+    {
+        const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        const std::size_t n = std::min(count, Room(tail, count));
+        for (std::size_t i = 0; i < n; i++, ++first)
+        {
+            m_slots[(tail + i) & m_mask] = std::move(*first);
+        }
+        if (n != 0)
+        {
+            m_tail.store(tail + n, std::memory_order_release);
+        }
+        return n;
+    }
+
+    /**
+     * Slot for writing the next item in place. The item is published
+     * by Commit(). Until then, Reserve() returns the same slot.
+     *
+     * @return Slot or nullptr if the ring is full
+     */
+    T* Reserve() noexcept
+    {
+        const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        return HasRoom(tail, 1) ? &m_slots[tail & m_mask] : nullptr;
+    }
+
+    /**
+     * Publish the slot obtained from Reserve()
+     */
+    void Commit() noexcept
+    {
+        m_tail.store(m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Consumer
+
+    bool TryPop(T& destination) noexcept(std::is_nothrow_move_assignable_v<T>)
+    {
+        const std::size_t head = m_head.load(std::memory_order_relaxed);
+        if (!HasItems(head, 1))
+        {
+            return false;
+        }
+        destination = std::move(m_slots[head & m_mask]);
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Move up to maxCount items to an output iterator, releasing their
+     * slots at once
+     *
+     * @param out - output iterator
+     * @param maxCount - maximum number of items
+     * @return Number of items popped
+     */
+    template <typename OutputIt>
+    std::size_t TryPopBatch(OutputIt out, std::size_t maxCount)
+    {
+        const std::size_t head = m_head.load(std::memory_order_relaxed);
+        const std::size_t n = std::min(maxCount, Items(head, maxCount));
+        for (std::size_t i = 0; i < n; i++, ++out)
+        {
+            *out = std::move(m_slots[(head + i) & m_mask]);
+        }
+        if (n != 0)
+        {
+            m_head.store(head + n, std::memory_order_release);
+        }
+        return n;
+    }
+
+    /**
+     * Oldest item for reading in place. The slot is released by Consume().
+     *
+     * @return Item or nullptr if the ring is empty
+     */
+    T* Peek() noexcept
+    {
+        const std::size_t head = m_head.load(std::memory_order_relaxed);
+        return HasItems(head, 1) ? &m_slots[head & m_mask] : nullptr;
+    }
+
+    /**
+     * Release the slot obtained from Peek()
+     */
+    void Consume() noexcept
+    {
+        m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Any thread, approximate when called concurrently
+
+    bool Empty() const noexcept
+    {
+        return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+    }
+
+    std::size_t SizeGet() const noexcept
+    {
+        const std::size_t head = m_head.load(std::memory_order_acquire);
+        const std::size_t tail = m_tail.load(std::memory_order_acquire);
+        return tail - head;
+    }
+
+  private:
+    // Number of free slots, at least wanted if possible (producer)
+    std::size_t Room(std::size_t tail, std::size_t wanted) noexcept
+    {
+        std::size_t room = Capacity() - (tail - m_cachedHead);
+        if (room < wanted)
+        {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            room = Capacity() - (tail - m_cachedHead);
+        }
+        return room;
+    }
+
+    bool HasRoom(std::size_t tail, std::size_t wanted) noexcept
+    {
+        return Room(tail, wanted) >= wanted;
+    }
+
+    // Number of available items, at least wanted if possible (consumer)
+    std::size_t Items(std::size_t head, std::size_t wanted) noexcept
+    {
+        std::size_t items = m_cachedTail - head;
+        if (items < wanted)
+        {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            items = m_cachedTail - head;
+        }
+        return items;
+    }
+
+    bool HasItems(std::size_t head, std::size_t wanted) noexcept
+    {
+        return Items(head, wanted) >= wanted;
+    }
+
+    // Consumer line
+    alignas(PREFETCH_PAIR_SIZE) std::atomic<std::size_t> m_head{ 0 };
+    std::size_t m_cachedTail{ 0 };
+
+    // Producer line
+    alignas(PREFETCH_PAIR_SIZE) std::atomic<std::size_t> m_tail{ 0 };
+    std::size_t m_cachedHead{ 0 };
+
+    // Shared, read-only after construction
+    alignas(PREFETCH_PAIR_SIZE) std::vector<T> m_slots;
+    const std::size_t m_mask;
+};
+
+} // namespace detail::v20
+
+template <typename T>
+using SPSCRing = detail::v20::SPSCRing<T>;
+} // namespace PBB
@@ -0,0 +1,249 @@
+/**
+ * @file   SegmentedQueue.hpp
+ * @author Jens Munk Hansen <jens.munk.hansen@gmail.com>
+ * @date   Tue Oct 20 09:14:31 CEST 2026
+ *
+ * @brief  FIFO storage in linked fixed-size segments, recycled
+ *         through a free list
+ *
+ * Copyright 2025 Jens Munk Hansen
+ *
+ */
+#pragma once
+
+#if __cplusplus < 202002L
+#error "This header requires at least C++20"
+#endif
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include <PBB/Common.hpp>
+
+namespace PBB
+{
+namespace detail::v20
+{
+//! QueueSegment
+/*!
+  Fixed-size array of uninitialized slots. Items live in [head, tail).
+ */
+template <typename T, std::size_t SegmentSize>
+struct QueueSegment
+{
+    QueueSegment* pNext{ nullptr };
+    std::size_t head{ 0 };
+    std::size_t tail{ 0 };
+    alignas(T) std::byte storage[SegmentSize * sizeof(T)];
+
+    // Raw storage of a slot, for constructing an item
+    void* SlotStorage(std::size_t index) noexcept { return storage + index * sizeof(T); }
+
+    // Item constructed in a slot
+    T* Slot(std::size_t index) noexcept
+    {
+        return std::launder(reinterpret_cast<T*>(storage + index * sizeof(T)));
+    }
+};
+
+template <typename T, std::size_t SegmentSize>
+using SegmentPtr = std::unique_ptr<QueueSegment<T, SegmentSize>>;
+
+//! SegmentFreeList
+/*!
+  Bounded stack of empty segments. Not thread-safe, except for
+  CountHint(), which producers read without holding the owner's lock
+  to decide whether to allocate a segment up front.
+ */
+template <typename T, std::size_t SegmentSize>
+class SegmentFreeList
+{
+  public:
+    using Segment = QueueSegment<T, SegmentSize>;
+
+    explicit SegmentFreeList(std::size_t limit) noexcept
+      : m_limit(limit)
+    {
+    }
+    PBB_DELETE_COPY_CTORS(SegmentFreeList);
+
+    ~SegmentFreeList() noexcept
+    {
+        while (m_pHead)
+        {
+            delete std::exchange(m_pHead, m_pHead->pNext);
+        }
+    }
+
+    /**
+     * Take a segment
+     *
+     * @return Segment or nullptr if the free list is empty
+     */
+    Segment* Pop() noexcept
+    {
+        Segment* pSegment = m_pHead;
+        if (pSegment)
+        {
+            m_pHead = pSegment->pNext;
+            m_count.store(m_count.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+        }
+        return pSegment;
+    }
+
+    /**
+     * Return a segment
+     *
+     * @return The segment, if the free list is full, to be deleted by
+     *         the caller once it has released its lock
+     */
+    SegmentPtr<T, SegmentSize> Push(SegmentPtr<T, SegmentSize> pSegment) noexcept
+    {
+        const std::size_t count = m_count.load(std::memory_order_relaxed);
+        if (!pSegment || count >= m_limit)
+        {
+            return pSegment;
+        }
+        pSegment->pNext = m_pHead;
+        m_pHead = pSegment.release();
+        m_count.store(count + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    std::size_t CountHint() const noexcept { return m_count.load(std::memory_order_relaxed); }
+
+  private:
+    Segment* m_pHead{ nullptr };
+    std::atomic<std::size_t> m_count{ 0 };
+    const std::size_t m_limit;
+};
+
+//! SegmentedQueue
+/*!
+  Unbounded FIFO of linked fixed-size segments. Not thread-safe. The
+  queue never allocates: a push that needs a new segment takes it from
+  the owner, and a pop that empties a segment hands it back, such that
+  the owner can allocate and delete segments outside of its lock. When
+  the queue becomes empty, its last segment is rewound and kept.
+ */
+template <typename T, std::size_t SegmentSize>
+class SegmentedQueue
+{
+    static_assert(SegmentSize > 0, "Segments must hold at least one item");
+
+  public:
+    using Segment = QueueSegment<T, SegmentSize>;
+
+    SegmentedQueue() noexcept = default;
+    SegmentedQueue(const SegmentedQueue&) = delete;
+    SegmentedQueue& operator=(const SegmentedQueue&) = delete;
+
+    SegmentedQueue(SegmentedQueue&& other) noexcept
+      : m_pHead(std::exchange(other.m_pHead, nullptr))
+      , m_pTail(std::exchange(other.m_pTail, nullptr))
+      , m_size(std::exchange(other.m_size, 0))
+    {
+    }
+
+    SegmentedQueue& operator=(SegmentedQueue&& other) noexcept
+    {
+        if (this != &other)
+        {
+            Release();
+            m_pHead = std::exchange(other.m_pHead, nullptr);
+            m_pTail = std::exchange(other.m_pTail, nullptr);
+            m_size = std::exchange(other.m_size, 0);
+        }
+        return *this;
+    }
+
+    ~SegmentedQueue() noexcept { Release(); }
+
+    bool Empty() const noexcept { return m_size == 0; }
+    std::size_t Size() const noexcept { return m_size; }
+
+    /**
+     * Whether the next push requires a segment
+     */
+    bool NeedsSegment() const noexcept { return !m_pTail || m_pTail->tail == SegmentSize; }
+
+    /**
+     * Append an item
+     *
+     * @param item - item
+     * @param pSegment - empty segment, required if NeedsSegment()
+     */
+    template <typename U>
+    void Push(U&& item, Segment* pSegment) noexcept(std::is_nothrow_constructible_v<T, U&&>)
+    {
+        if (NeedsSegment())
+        {
+            pSegment->pNext = nullptr;
+            pSegment->head = 0;
+            pSegment->tail = 0;
+            if (m_pTail)
+            {
+                m_pTail->pNext = pSegment;
+            }
+            else
+            {
+                m_pHead = pSegment;
+            }
+            m_pTail = pSegment;
+        }
+        ::new (m_pTail->SlotStorage(m_pTail->tail)) T(std::forward<U>(item));
+        m_pTail->tail++;
+        m_size++;
+    }
+
+    T& Front() noexcept { return *m_pHead->Slot(m_pHead->head); }
+
+    /**
+     * Remove the first item
+     *
+     * @return The first segment, if it was emptied and is not the last one
+     */
+    SegmentPtr<T, SegmentSize> Pop() noexcept
+    {
+        std::destroy_at(m_pHead->Slot(m_pHead->head));
+        m_pHead->head++;
+        m_size--;
+        if (m_pHead->head != m_pHead->tail)
+        {
+            return nullptr;
+        }
+        if (m_pHead == m_pTail)
+        {
+            // Empty, rewind the last segment
+            m_pHead->head = 0;
+            m_pHead->tail = 0;
+            return nullptr;
+        }
+        return SegmentPtr<T, SegmentSize>(std::exchange(m_pHead, m_pHead->pNext));
+    }
+
+  private:
+    void Release() noexcept
+    {
+        while (m_pHead)
+        {
+            for (std::size_t i = m_pHead->head; i < m_pHead->tail; i++)
+            {
+                std::destroy_at(m_pHead->Slot(i));
+            }
+            delete std::exchange(m_pHead, m_pHead->pNext);
+        }
+        m_pTail = nullptr;
+        m_size = 0;
+    }
+
+    Segment* m_pHead{ nullptr };
+    Segment* m_pTail{ nullptr };
+    std::size_t m_size{ 0 };
+};
+
+} // namespace detail::v20
+} // namespace PBB
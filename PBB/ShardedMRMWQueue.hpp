@@ -0,0 +1,449 @@
+/**
+ * @file   ShardedMRMWQueue.hpp
+ * @author Jens Munk Hansen <jens.munk.hansen@gmail.com>
+ * @date   Mon Oct 19 17:12:48 CEST 2026
+ *
+ * @brief  Multi-reader-multi-writer queue sharded over independently
+ *         locked MRMWQueues
+ *
+ * Copyright 2025 Jens Munk Hansen
+ *
+ */
+#pragma once
+
+#if __cplusplus < 202002L
+#error "This header requires at least C++20"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include <PBB/Common.hpp>
+#include <PBB/MRMWQueue.hpp>
+#include <PBB/Memory.hpp>
+#include <PBB/Probes.hpp>
+#include <PBB/ProfiledMutex.hpp>
+
+namespace PBB
+{
+namespace detail::v20
+{
+//! ShardedMRMWQueue
+/*!
+  Blocking multi-reader-multi-writer queue consisting of independently
+  locked @ref MRMWQueue shards, each on its own cache lines, such that
+  producers and consumers mostly contend on different mutexes.
+
+  A producer pushes to the shard selected by a hash of its thread id,
+  and only falls back to other shards if its own shard is full. A
+  consumer starts at its home shard, selected in the same way, and
+  rotates through the others. FIFO order and lane priorities hold per
+  shard, not globally.
+
+  Idle consumers park on a single condition. An epoch, advanced by
+  every push, prevents lost wake-ups, and pushes only notify if
+  consumers are parked. An approximate item count tells TryPop() to
+  skip scanning an empty queue, and a closed queue when it is drained.
+
+  The interface matches MRMWQueue, such that it can be used as the
+  work queue of a thread pool.
+ */
+template <typename T, std::size_t Lanes = 1>
+class ShardedMRMWQueue
+{
+  public:
+    using Shard = MRMWQueue<T, Lanes>;
+    static constexpr std::size_t NumLanes = Lanes;
+
+    /**
+     * Constructor
+     *
+     * @param nShards - number of shards, zero for one per hardware thread (at most 16)
+     */
+    explicit ShardedMRMWQueue(std::size_t nShards = 0)
+      : m_shards(nShards != 0 ? nShards : DefaultShardCount())
+    {
+    }
+    PBB_DELETE_COPY_CTORS(ShardedMRMWQueue);
+
+    ~ShardedMRMWQueue() noexcept { Invalidate(); }
+
+    std::size_t NShardsGet() const noexcept { return m_shards.size(); }
+
+    bool TryPop(T& destination) noexcept
+    {
+        if (m_count.load(std::memory_order_acquire) == 0)
+        {
+            return false;
+        }
+        return TryPopAny(destination);
+    }
+
+    bool Pop(T& destination)
+    {
+        return PopUntil(destination, std::chrono::steady_clock::time_point::max());
+    }
+
+    /**
+     * Pop, waiting at most a given duration for an item
+     *
+     * @param destination - item
+     * @param timeout - maximum time to wait
+     * @return False on timeout or if the queue was invalidated
+     */
+    template <typename Rep, typename Period>
+    bool PopFor(T& destination, const std::chrono::duration<Rep, Period>& timeout)
+    {
+        return PopUntil(destination, std::chrono::steady_clock::now() + ClampTimeout(timeout));
+    }
+
+    /**
+     * Pop, waiting until a deadline for an item
+     *
+     * @param destination - item
+     * @param deadline - time point after which to give up
+     * @return False on timeout, if the queue was invalidated or is
+     *         closed and drained
+     */
+    template <typename Clock, typename Duration>
+    bool PopUntil(T& destination, const std::chrono::time_point<Clock, Duration>& deadline)
+    {
+        for (;;)
+        {
+            if (!Valid())
+            {
+                return false;
+            }
+            const std::uint64_t epoch = m_epoch.load(std::memory_order_seq_cst);
+            if (TryPopAny(destination))
+            {
+                return true;
+            }
+            if (Closed() && m_count.load(std::memory_order_acquire) == 0)
+            {
+                return false;
+            }
+            if (!Park(epoch, deadline))
+            {
+                // Final attempt, an item may have arrived at the deadline
+                return Valid() && TryPopAny(destination);
+            }
+        }
+    }
+
+    bool Push(T&& source) { return Push(std::move(source), 0); }
+
+    /**
+     * Push to a given lane. If all shards are full, wait for room in
+     * the home shard of the calling thread.
+     *
+     * @param source - item, not consumed if the push fails
+     * @param lane - lane in [0, NumLanes)
+     * @return False if the queue is closed or was invalidated while waiting for room
+     */
+    bool Push(T&& source, std::size_t lane)
+    {
+        return CountedPush(
+          [&]()
+          {
+              bool pushed = TryPushAny(source, lane);
+              if (!pushed && !Closed() && Valid())
+              {
+                  pushed = m_shards[HomeShard()].Push(std::move(source), lane);
+              }
+              return pushed;
+          });
+    }
+
+    /**
+     * Push without waiting, trying the home shard first
+     *
+     * @param source - item, not consumed if the push fails
+     * @param lane - lane in [0, NumLanes)
+     * @return False if all shards are full or the queue is closed
+     */
+    bool TryPush(T&& source, std::size_t lane = 0)
+    {
+        return CountedPush([&]() { return TryPushAny(source, lane); });
+    }
+
+    /**
+     * Push, waiting until a deadline for room in the home shard if all
+     * shards are full
+     *
+     * @param source - item, not consumed if the push fails
+     * @param deadline - time point after which to give up
+     * @param lane - lane in [0, NumLanes)
+     * @return False if there is still no room at the deadline or the
+     *         queue was closed or invalidated
+     */
+    template <typename Clock, typename Duration>
+    bool TryPushUntil(T&& source, const std::chrono::time_point<Clock, Duration>& deadline,
+      std::size_t lane = 0)
+    {
+        return CountedPush(
+          [&]()
+          {
+              bool pushed = TryPushAny(source, lane);
+              if (!pushed && !Closed())
+              {
+                  pushed = m_shards[HomeShard()].TryPushUntil(std::move(source), deadline, lane);
+              }
+              return pushed;
+          });
+    }
+
+    template <typename Rep, typename Period>
+    bool TryPushFor(T&& source, const std::chrono::duration<Rep, Period>& timeout,
+      std::size_t lane = 0)
+    {
+        return TryPushUntil(
+          std::move(source), std::chrono::steady_clock::now() + ClampTimeout(timeout), lane);
+    }
+
+    /**
+     * Maximum number of queued items, divided evenly over the shards
+     * and rounded up. Zero (default) means unbounded.
+     */
+    void CapacitySet(std::size_t capacity) noexcept
+    {
+        const std::size_t perShard =
+          capacity == 0 ? 0 : (capacity + m_shards.size() - 1) / m_shards.size();
+        for (auto& shard : m_shards)
+        {
+            shard.CapacitySet(perShard);
+        }
+    }
+
+    std::size_t CapacityGet() const noexcept
+    {
+        return m_shards[0].CapacityGet() * m_shards.size();
+    }
+
+    /**
+     * Approximate number of items, exact when no pushes or pops are in progress
+     */
+    std::size_t Size() const noexcept { return m_count.load(std::memory_order_acquire); }
+
+    bool Empty() const noexcept { return Size() == 0; }
+
+    void Invalidate() noexcept
+    {
+        m_valid.store(false, std::memory_order_release);
+        for (auto& shard : m_shards)
+        {
+            shard.Invalidate();
+        }
+        WakeAll();
+    }
+
+    bool Valid() const noexcept { return m_valid.load(std::memory_order_acquire); }
+
+    /**
+     * Reject further pushes, while consumers drain the remaining items
+     */
+    void Close() noexcept
+    {
+        m_closed.store(true, std::memory_order_release);
+        for (auto& shard : m_shards)
+        {
+            shard.Close();
+        }
+        WakeAll();
+    }
+
+    bool Closed() const noexcept { return m_closed.load(std::memory_order_acquire); }
+
+    void Clear() noexcept
+    {
+        T item;
+        for (auto& shard : m_shards)
+        {
+            while (shard.TryPop(item))
+            {
+                m_count.fetch_sub(1, std::memory_order_acq_rel);
+            }
+        }
+    }
+
+    void AgingLimitSet(std::size_t agingLimit) noexcept
+    {
+        for (auto& shard : m_shards)
+        {
+            shard.AgingLimitSet(agingLimit);
+        }
+    }
+
+    std::size_t AgingLimitGet() const noexcept { return m_shards[0].AgingLimitGet(); }
+
+    /**
+     * Snapshot of the queue telemetry, summed over the shards. The wait
+     * time is the time consumers were parked. Only the depth is
+     * reported, unless compiled with PBB_ENABLE_STATS.
+     */
+    QueueStats Stats() const noexcept
+    {
+        QueueStats stats;
+        for (const auto& shard : m_shards)
+        {
+            stats += shard.Stats();
+        }
+        stats.depth = Size();
+        m_counters.Collect(stats);
+        return stats;
+    }
+
+  private:
+    static std::size_t DefaultShardCount() noexcept
+    {
+        return std::clamp<std::size_t>(std::thread::hardware_concurrency(), 1, 16);
+    }
+
+    // Stable per thread, shared by all queues
+    static std::size_t ThreadHash() noexcept
+    {
+        thread_local const std::size_t hash =
+          std::hash<std::thread::id>{}(std::this_thread::get_id());
+        return hash;
+    }
+
+    std::size_t HomeShard() const noexcept { return ThreadHash() % m_shards.size(); }
+
+    bool TryPopAny(T& destination) noexcept
+    {
+        const std::size_t home = HomeShard();
+        for (std::size_t i = 0; i < m_shards.size(); i++)
+        {
+            if (m_shards[(home + i) % m_shards.size()].TryPop(destination))
+            {
+                m_count.fetch_sub(1, std::memory_order_acq_rel);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool TryPushAny(T& source, std::size_t lane)
+    {
+        const std::size_t home = HomeShard();
+        for (std::size_t i = 0; i < m_shards.size() && !Closed(); i++)
+        {
+            if (m_shards[(home + i) % m_shards.size()].TryPush(std::move(source), lane))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // The count is incremented before pushing, such that it never
+    // drops below the number of queued items. It is undone if the push
+    // fails or a shard throws std::bad_alloc.
+    template <typename PushFn>
+    bool CountedPush(PushFn&& push)
+    {
+        m_count.fetch_add(1, std::memory_order_acq_rel);
+        bool pushed = false;
+        try
+        {
+            pushed = push();
+        }
+        catch (...)
+        {
+            m_count.fetch_sub(1, std::memory_order_acq_rel);
+            throw;
+        }
+        return Published(pushed);
+    }
+
+    // Undo the count on failure, or wake a parked consumer on success
+    bool Published(bool pushed) noexcept
+    {
+        if (!pushed)
+        {
+            m_count.fetch_sub(1, std::memory_order_acq_rel);
+            return false;
+        }
+        m_counters.RaisePeak(m_count.load(std::memory_order_relaxed));
+        m_epoch.fetch_add(1, std::memory_order_seq_cst);
+        if (m_sleepers.load(std::memory_order_seq_cst) != 0)
+        {
+            std::lock_guard<ParkMutex> guard{ m_parkMutex };
+            m_parkCondition.notify_one();
+        }
+        return true;
+    }
+
+    /**
+     * Wait for a push after the given epoch, closing or invalidation
+     *
+     * @return False on timeout
+     */
+    template <typename Clock, typename Duration>
+    bool Park(std::uint64_t epoch, const std::chrono::time_point<Clock, Duration>& deadline)
+    {
+        std::unique_lock<ParkMutex> lock{ m_parkMutex };
+        m_sleepers.fetch_add(1, std::memory_order_seq_cst);
+        const auto waitStart = m_counters.WaitBegin();
+        PBB_PROBE2(queue_block, this, 0);
+        const bool woken = m_parkCondition.wait_until(lock, deadline,
+          [&]
+          {
+              return m_epoch.load(std::memory_order_seq_cst) != epoch || Closed() || !Valid();
+          });
+        PBB_PROBE2(queue_unblock, this, 0);
+        m_counters.WaitEnd(waitStart);
+        m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+        return woken;
+    }
+
+    void WakeAll() noexcept
+    {
+        std::lock_guard<ParkMutex> guard{ m_parkMutex };
+        m_parkCondition.notify_all();
+    }
+
+    template <typename Rep, typename Period>
+    static std::chrono::steady_clock::duration ClampTimeout(
+      const std::chrono::duration<Rep, Period>& timeout) noexcept
+    {
+        // Avoid overflowing the deadline for very long timeouts
+        constexpr auto maxTimeout = std::chrono::hours(24 * 365);
+        if (std::chrono::duration<double>(timeout) >= std::chrono::duration<double>(maxTimeout))
+        {
+            return maxTimeout;
+        }
+        return std::max(std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeout),
+          std::chrono::steady_clock::duration::zero());
+    }
+
+    CacheAlignedArray<Shard, PREFETCH_PAIR_SIZE> m_shards;
+
+    // Shared by producers and consumers
+    alignas(PREFETCH_PAIR_SIZE) std::atomic<std::size_t> m_count{ 0 }; ///< Approximate item count
+    std::atomic<std::uint64_t> m_epoch{ 0 }; ///< Advanced by every push
+    std::atomic<std::size_t> m_sleepers{ 0 };
+    std::atomic<bool> m_valid{ true };
+    std::atomic<bool> m_closed{ false };
+
+    // Parked consumers
+    using ParkMutex = Mutex<"ShardedMRMWQueue::m_parkMutex">;
+    alignas(PREFETCH_PAIR_SIZE) ParkMutex m_parkMutex;
+    ConditionVariable m_parkCondition;
+
+    // Park time and peak depth, the shards count the rest
+    [[no_unique_address]] QueueCounters m_counters;
+};
+
+} // namespace detail::v20
+
+template <typename T, std::size_t Lanes = 1>
+using ShardedMRMWQueue = detail::v20::ShardedMRMWQueue<T, Lanes>;
+} // namespace PBB
@@ -0,0 +1,400 @@
+#pragma once
+
+#if __cplusplus < 202002L
+#error "This header requires C++20"
+#endif
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <type_traits>
+
+#include <PBB/Common.hpp>
+#include <PBB/Config.h>
+#include <PBB/Memory.hpp>
+#include <PBB/ProfiledMutex.hpp>
+
+// Size-class slab allocator for task objects and their shared states.
+//
+// Every thread allocates from its own cache of free lists, one per size
+// class. A block freed by another thread (typically a worker freeing a
+// task submitted by a producer) is collected in a per-thread batch and
+// returned to the owning cache in one atomic operation, once the batch
+// is full. The owner picks up all returned blocks at once, when its
+// local free list runs dry. Slabs are never returned to the heap, so
+// in a steady state neither submitting nor executing touches malloc.
+
+namespace PBB::Thread
+{
+namespace detail
+{
+constexpr std::size_t TaskMinBlockSize = 64;
+constexpr std::size_t TaskNumSizeClasses = 6; // 64, 128, ..., 2048 bytes
+constexpr std::size_t TaskLargeClass = TaskNumSizeClasses;
+constexpr std::size_t TaskSlabSize = 64 * 1024;
+constexpr std::size_t TaskRemoteBatchSize = 32;
+
+struct TaskFreeBlock
+{
+    TaskFreeBlock* pNext;
+};
+
+// Header preceding every allocation
+struct alignas(16) TaskBlockHeader
+{
+    void* pOwner;            // Owning cache, nullptr for heap blocks
+    std::uint32_t sizeClass; // Size class or TaskLargeClass
+    std::uint32_t offset;    // Offset from start of heap block to payload
+};
+static_assert(sizeof(TaskBlockHeader) == 16, "Padding issue detected!");
+
+inline std::size_t TaskSizeClassGet(std::size_t bytes) noexcept
+{
+    std::size_t sizeClass = 0;
+    std::size_t blockSize = TaskMinBlockSize;
+    while (blockSize < bytes && sizeClass < TaskLargeClass)
+    {
+        blockSize <<= 1;
+        ++sizeClass;
+    }
+    return sizeClass;
+}
+
+//! TaskCache
+/*!
+  Free lists of a single thread. The local lists are only touched by
+  the owning thread, the remote lists receive batches from others.
+ */
+class alignas(CACHE_LINE_SIZE) TaskCache
+{
+  public:
+    TaskCache() = default;
+    PBB_DELETE_COPY_CTORS(TaskCache);
+
+    // Owner only
+    TaskFreeBlock* Pop(std::size_t sizeClass)
+    {
+        TaskFreeBlock* pBlock = m_local[sizeClass];
+        if (!pBlock)
+        {
+            // Collect everything returned by other threads
+            pBlock = m_remote[sizeClass].exchange(nullptr, std::memory_order_acquire);
+            if (!pBlock)
+            {
+                pBlock = Refill(sizeClass);
+            }
+        }
+        m_local[sizeClass] = pBlock->pNext;
+        return pBlock;
+    }
+
+    // Owner only
+    void PushLocal(TaskFreeBlock* pBlock, std::size_t sizeClass) noexcept
+    {
+        pBlock->pNext = m_local[sizeClass];
+        m_local[sizeClass] = pBlock;
+    }
+
+    // Any thread. Push-only stack, where the owner takes everything, so ABA is harmless.
+    void PushRemote(TaskFreeBlock* pFirst, TaskFreeBlock* pLast, std::size_t sizeClass) noexcept
+    {
+        TaskFreeBlock* pHead = m_remote[sizeClass].load(std::memory_order_relaxed);
+        do
+        {
+            pLast->pNext = pHead;
+        } while (!m_remote[sizeClass].compare_exchange_weak(
+          pHead, pFirst, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    TaskCache* m_pNextOrphan = nullptr; // Link used by the registry
+
+  private:
+    TaskFreeBlock* Refill(std::size_t sizeClass)
+    {
+        // The first block of a slab links the slabs of the cache
+        auto* pSlab =
+          static_cast<std::byte*>(::operator new(TaskSlabSize, std::align_val_t(CACHE_LINE_SIZE)));
+        *reinterpret_cast<void**>(pSlab) = m_pSlabs;
+        m_pSlabs = pSlab;
+
+        const std::size_t blockSize = TaskMinBlockSize << sizeClass;
+        TaskFreeBlock* pFirst = nullptr;
+        for (std::size_t offset = TaskSlabSize - blockSize; offset >= TaskMinBlockSize;
+             offset -= blockSize)
+        {
+            auto* pBlock = reinterpret_cast<TaskFreeBlock*>(pSlab + offset);
+            pBlock->pNext = pFirst;
+            pFirst = pBlock;
+        }
+        return pFirst;
+    }
+
+    TaskFreeBlock* m_local[TaskNumSizeClasses] = {};
+    void* m_pSlabs = nullptr;
+    alignas(CACHE_LINE_SIZE) std::atomic<TaskFreeBlock*> m_remote[TaskNumSizeClasses] = {};
+};
+
+//! TaskCacheRegistry
+/*!
+  Keeps caches of exited threads, such that they can be adopted by new
+  threads. Caches are never destroyed, since blocks can outlive the
+  thread which allocated them.
+ */
+class TaskCacheRegistry
+{
+  public:
+    static TaskCacheRegistry& InstanceGet()
+    {
+        // Intentionally leaked to be usable during thread and process exit
+        static TaskCacheRegistry* pInstance = new TaskCacheRegistry();
+        return *pInstance;
+    }
+
+    TaskCache* Acquire()
+    {
+        {
+            std::lock_guard guard(m_mutex);
+            if (m_pOrphans)
+            {
+                TaskCache* pCache = m_pOrphans;
+                m_pOrphans = pCache->m_pNextOrphan;
+                pCache->m_pNextOrphan = nullptr;
+                return pCache;
+            }
+        }
+        return new TaskCache();
+    }
+
+    void Release(TaskCache* pCache) noexcept
+    {
+        std::lock_guard guard(m_mutex);
+        pCache->m_pNextOrphan = m_pOrphans;
+        m_pOrphans = pCache;
+    }
+
+  private:
+    TaskCacheRegistry() = default;
+    Mutex<"TaskCacheRegistry::m_mutex"> m_mutex;
+    TaskCache* m_pOrphans = nullptr;
+};
+
+//! TaskThreadState
+/*!
+  Per-thread cache and pending batches of blocks owned by other threads
+ */
+class TaskThreadState
+{
+  public:
+    TaskThreadState() = default;
+    PBB_DELETE_COPY_CTORS(TaskThreadState);
+
+    ~TaskThreadState()
+    {
+        for (std::size_t sizeClass = 0; sizeClass < TaskNumSizeClasses; sizeClass++)
+        {
+            Flush(sizeClass);
+        }
+        if (m_pCache)
+        {
+            TaskCacheRegistry::InstanceGet().Release(m_pCache);
+        }
+        ExitedRef() = true;
+    }
+
+    /**
+     * State of the calling thread, nullptr during thread exit
+     */
+    static TaskThreadState* Get() noexcept
+    {
+        if (ExitedRef())
+        {
+            return nullptr;
+        }
+#if defined(__clang__)
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wexit-time-destructors"
+#endif
+        thread_local TaskThreadState state;
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#endif
+        return &state;
+    }
+
+    TaskCache* Cache() noexcept { return m_pCache; }
+
+    TaskCache* CacheGet()
+    {
+        if (!m_pCache)
+        {
+            m_pCache = TaskCacheRegistry::InstanceGet().Acquire();
+        }
+        return m_pCache;
+    }
+
+    void Defer(TaskCache* pOwner, TaskFreeBlock* pBlock, std::size_t sizeClass) noexcept
+    {
+        Pending& pending = m_pending[sizeClass];
+        if (pending.pOwner != pOwner)
+        {
+            Flush(sizeClass);
+            pending.pOwner = pOwner;
+        }
+        pBlock->pNext = pending.pFirst;
+        pending.pFirst = pBlock;
+        if (!pending.pLast)
+        {
+            pending.pLast = pBlock;
+        }
+        if (++pending.count == TaskRemoteBatchSize)
+        {
+            Flush(sizeClass);
+        }
+    }
+
+  private:
+    struct Pending
+    {
+        TaskCache* pOwner = nullptr;
+        TaskFreeBlock* pFirst = nullptr;
+        TaskFreeBlock* pLast = nullptr;
+        std::size_t count = 0;
+    };
+
+    void Flush(std::size_t sizeClass) noexcept
+    {
+        Pending& pending = m_pending[sizeClass];
+        if (pending.pFirst)
+        {
+            pending.pOwner->PushRemote(pending.pFirst, pending.pLast, sizeClass);
+        }
+        pending = Pending{};
+    }
+
+    static bool& ExitedRef() noexcept
+    {
+        thread_local bool exited = false;
+        return exited;
+    }
+
+    TaskCache* m_pCache = nullptr;
+    Pending m_pending[TaskNumSizeClasses];
+};
+} // namespace detail
+
+//! TaskMemory
+/*!
+  Allocation of task objects and their shared states. Falls back to
+  the heap for large or over-aligned objects, during thread exit or
+  when PBB_USE_TASK_POOL is disabled.
+ */
+struct TaskMemory
+{
+    PBB_DELETE_CTORS(TaskMemory);
+
+    static void* Allocate(std::size_t size, std::size_t alignment)
+    {
+#ifdef PBB_USE_TASK_POOL
+        const std::size_t sizeClass =
+          detail::TaskSizeClassGet(size + sizeof(detail::TaskBlockHeader));
+        if (sizeClass < detail::TaskNumSizeClasses &&
+          alignment <= alignof(detail::TaskBlockHeader))
+        {
+            if (detail::TaskThreadState* pState = detail::TaskThreadState::Get())
+            {
+                detail::TaskCache* pCache = pState->CacheGet();
+                auto* pHeader = reinterpret_cast<detail::TaskBlockHeader*>(pCache->Pop(sizeClass));
+                pHeader->pOwner = pCache;
+                pHeader->sizeClass = static_cast<std::uint32_t>(sizeClass);
+                pHeader->offset = sizeof(detail::TaskBlockHeader);
+                return pHeader + 1;
+            }
+        }
+#endif
+        return AllocateLarge(size, alignment);
+    }
+
+    static void Deallocate(void* p) noexcept
+    {
+        if (!p)
+        {
+            return;
+        }
+        auto* pHeader = static_cast<detail::TaskBlockHeader*>(p) - 1;
+        const std::size_t sizeClass = pHeader->sizeClass;
+        if (sizeClass == detail::TaskLargeClass)
+        {
+            const std::size_t offset = pHeader->offset;
+            ::operator delete(static_cast<std::byte*>(p) - offset, std::align_val_t(offset));
+            return;
+        }
+
+        auto* pOwner = static_cast<detail::TaskCache*>(pHeader->pOwner);
+        auto* pBlock = reinterpret_cast<detail::TaskFreeBlock*>(pHeader);
+        detail::TaskThreadState* pState = detail::TaskThreadState::Get();
+        if (pState && pState->Cache() == pOwner)
+        {
+            pOwner->PushLocal(pBlock, sizeClass);
+        }
+        else if (pState)
+        {
+            pState->Defer(pOwner, pBlock, sizeClass);
+        }
+        else
+        {
+            pOwner->PushRemote(pBlock, pBlock, sizeClass);
+        }
+    }
+
+  private:
+    static void* AllocateLarge(std::size_t size, std::size_t alignment)
+    {
+        const std::size_t offset = alignment > sizeof(detail::TaskBlockHeader)
+          ? alignment
+          : sizeof(detail::TaskBlockHeader);
+        auto* pBase =
+          static_cast<std::byte*>(::operator new(offset + size, std::align_val_t(offset)));
+        auto* pHeader = reinterpret_cast<detail::TaskBlockHeader*>(pBase + offset) - 1;
+        pHeader->pOwner = nullptr;
+        pHeader->sizeClass = static_cast<std::uint32_t>(detail::TaskLargeClass);
+        pHeader->offset = static_cast<std::uint32_t>(offset);
+        return pBase + offset;
+    }
+};
+
+//! TaskAllocator
+/*!
+  STL-compatible allocator using @ref TaskMemory, e.g. for the shared
+  state of std::promise or std::allocate_shared.
+ */
+template <typename T>
+class TaskAllocator
+{
+  public:
+    using value_type = T;
+    using is_always_equal = std::true_type;
+
+    TaskAllocator() noexcept = default;
+
+    template <typename U>
+    TaskAllocator(const TaskAllocator<U>&) noexcept
+    {
+    }
+
+    T* allocate(std::size_t n)
+    {
+        return static_cast<T*>(TaskMemory::Allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, std::size_t) noexcept { TaskMemory::Deallocate(p); }
+
+    template <typename U>
+    bool operator==(const TaskAllocator<U>&) const noexcept
+    {
+        return true;
+    }
+};
+
+} // namespace PBB::Thread
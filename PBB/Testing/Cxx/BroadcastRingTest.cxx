@@ -0,0 +1,118 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <PBB/BroadcastRing.hpp>
+
+TEST_CASE("BroadcastRing_ProducerGatesOnSlowestConsumer", "[BroadcastRing]")
+{
+    PBB::BroadcastRing<int> ring(4, 2);
+    REQUIRE(ring.Capacity() == 4);
+    REQUIRE(ring.NConsumersGet() == 2);
+
+    for (int i = 0; i < 4; i++)
+    {
+        REQUIRE(ring.TryPush(i));
+    }
+    REQUIRE_FALSE(ring.TryPush(4));
+
+    // One consumer catching up is not enough
+    for (int i = 0; i < 4; i++)
+    {
+        const int* pItem = ring.TryPeek(0);
+        REQUIRE(pItem != nullptr);
+        REQUIRE(*pItem == i);
+        ring.Consume(0);
+    }
+    REQUIRE(ring.TryPeek(0) == nullptr);
+    REQUIRE(ring.TryClaim() == nullptr);
+
+    REQUIRE(ring.Available(1) == 4);
+    REQUIRE(ring.At(1, 3) == 3);
+    ring.Consume(1, 2);
+    REQUIRE(ring.TryPush(4));
+    REQUIRE(ring.TryPush(5));
+    REQUIRE_FALSE(ring.TryPush(6));
+}
+
+TEST_CASE("BroadcastRing_ClaimPublish_ReadsInPlace", "[BroadcastRing]")
+{
+    PBB::BroadcastRing<std::vector<float>> ring(2, 3);
+    std::vector<float>* pFrame = ring.TryClaim();
+    REQUIRE(pFrame != nullptr);
+    REQUIRE(ring.TryClaim() == pFrame);
+    pFrame->assign(1024, 2.0f);
+    ring.Publish();
+
+    // All consumers see the same object
+    for (std::size_t consumer = 0; consumer < 3; consumer++)
+    {
+        REQUIRE(ring.TryPeek(consumer) == pFrame);
+        ring.Consume(consumer);
+    }
+}
+
+TEST_CASE("BroadcastRing_ConsumersSeeEveryItem", "[BroadcastRing]")
+{
+    constexpr std::uint64_t nItems = 200000;
+    constexpr std::size_t nConsumers = 3;
+    PBB::BroadcastRing<std::uint64_t> ring(256, nConsumers);
+
+    std::vector<std::uint64_t> sums(nConsumers, 0);
+    std::vector<char> ordered(nConsumers, 0);
+    std::vector<std::thread> consumers;
+    for (std::size_t c = 0; c < nConsumers; c++)
+    {
+        consumers.emplace_back(
+          [&, c]
+          {
+              bool ok = true;
+              std::uint64_t sum = 0;
+              for (std::uint64_t expected = 0; expected < nItems;)
+              {
+                  // Alternate blocking reads and batches read in place
+                  if (expected % 2 == 0)
+                  {
+                      const std::uint64_t item = *ring.Wait(c);
+                      ok = ok && item == expected++;
+                      sum += item;
+                      ring.Consume(c);
+                      continue;
+                  }
+                  const std::size_t available = ring.Available(c);
+                  if (available == 0)
+                  {
+                      std::this_thread::yield();
+                      continue;
+                  }
+                  for (std::size_t i = 0; i < available; i++)
+                  {
+                      const std::uint64_t item = ring.At(c, i);
+                      ok = ok && item == expected++;
+                      sum += item;
+                  }
+                  ring.Consume(c, available);
+              }
+              sums[c] = sum;
+              ordered[c] = ok ? 1 : 0;
+          });
+    }
+
+    for (std::uint64_t i = 0; i < nItems; i++)
+    {
+        *ring.Claim() = i;
+        ring.Publish();
+    }
+    for (auto& thread : consumers)
+    {
+        thread.join();
+    }
+
+    for (std::size_t c = 0; c < nConsumers; c++)
+    {
+        REQUIRE(ordered[c] == 1);
+        REQUIRE(sums[c] == nItems * (nItems - 1) / 2);
+    }
+}
@@ -0,0 +1,68 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#include <PBB/Clock.hpp>
+#include <PBB/LatencyHistogram.hpp>
+
+TEST_CASE("LatencyHistogram_Buckets_BoundedRelativeError", "[LatencyHistogram]")
+{
+    using Histogram = PBB::LatencyHistogram;
+    // Small values are exact
+    for (std::uint64_t value = 0; value < 2 * Histogram::SubBuckets; value++)
+    {
+        REQUIRE(Histogram::BucketValue(Histogram::BucketIndex(value)) == value);
+    }
+
+    std::size_t previous = 0;
+    for (std::uint64_t value = 1; value < (std::uint64_t{ 1 } << 40); value = value * 3 / 2 + 1)
+    {
+        const std::size_t index = Histogram::BucketIndex(value);
+        REQUIRE(index < Histogram::BucketCount);
+        REQUIRE(index >= previous);
+        previous = index;
+        const double represented = static_cast<double>(Histogram::BucketValue(index));
+        const double error =
+          (represented - static_cast<double>(value)) / static_cast<double>(value);
+        REQUIRE(error < 1.0 / Histogram::SubBuckets);
+        REQUIRE(error > -1.0 / Histogram::SubBuckets);
+    }
+    REQUIRE(Histogram::BucketIndex(~std::uint64_t{ 0 }) == Histogram::BucketCount - 1);
+}
+
+TEST_CASE("LatencyHistogram_Percentiles_MergedHistograms", "[LatencyHistogram]")
+{
+    PBB::LatencyHistogram first;
+    PBB::LatencyHistogram second;
+    for (std::uint64_t value = 1; value <= 1000; value++)
+    {
+        (value % 2 == 0 ? first : second).Record(value * 1000);
+    }
+    PBB::LatencyHistogram merged;
+    merged.Merge(first);
+    merged.Merge(second);
+    REQUIRE(merged.Count() == 1000);
+
+    const auto within = [](std::uint64_t value, std::uint64_t expected)
+    { return value > expected * 15 / 16 && value < expected * 17 / 16; };
+    REQUIRE(within(merged.ValueAtFraction(0.5), 500000));
+    REQUIRE(within(merged.ValueAtFraction(0.99), 990000));
+    REQUIRE(within(merged.ValueAtFraction(0.999), 999000));
+    REQUIRE(PBB::LatencyHistogram{}.ValueAtFraction(0.5) == 0);
+}
+
+TEST_CASE("Clock_Calibrated_MatchesSteadyClock", "[Clock]")
+{
+    const auto start = std::chrono::steady_clock::now();
+    const PBB::Clock::Ticks startTicks = PBB::Clock::Now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    const PBB::Clock::Ticks endTicks = PBB::Clock::Now();
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    REQUIRE(endTicks > startTicks);
+    const auto measured = PBB::Clock::ToDuration(endTicks - startTicks);
+    REQUIRE(measured > elapsed * 9 / 10);
+    REQUIRE(measured < elapsed * 11 / 10);
+}
@@ -1,7 +1,10 @@
 #include <catch2/catch_test_macros.hpp>
 
+#include <atomic>
 #include <chrono>
+#include <memory>
 #include <thread>
+#include <vector>
 
 #include <PBB/MRMWQueue.hpp>
 
@@ -53,3 +56,311 @@ TEST_CASE("MRMWQueue_PushPop_NoErrors", "[MRMWQueue]")
   second.join();
   REQUIRE(true); // placeholder
 }
+
+TEST_CASE("MRMWQueue_Lanes_ServedInOrder", "[MRMWQueue]")
+{
+  PBB::MRMWQueue<int, 3> queue;
+  queue.Push(20, 2);
+  queue.Push(10, 1);
+  queue.Push(0, 0);
+  queue.Push(11, 1);
+  queue.Push(1, 0);
+
+  std::vector<int> values;
+  int value = 0;
+  while (queue.TryPop(value))
+  {
+    values.push_back(value);
+  }
+  REQUIRE(values == std::vector<int>{ 0, 1, 10, 11, 20 });
+  REQUIRE(queue.Empty());
+}
+
+TEST_CASE("MRMWQueue_Lanes_AgingPreventsStarvation", "[MRMWQueue]")
+{
+  PBB::MRMWQueue<int, 2> queue;
+  queue.AgingLimitSet(4);
+  for (int i = 0; i < 100; i++)
+  {
+    queue.Push(0, 0);
+  }
+  queue.Push(1, 1);
+
+  // The low-priority item is served after being bypassed four times
+  int value = -1;
+  int position = 0;
+  while (queue.TryPop(value) && value == 0)
+  {
+    position++;
+  }
+  REQUIRE(value == 1);
+  REQUIRE(position == 4);
+}
+
+TEST_CASE("MRMWQueue_Bounded_TryPushFailsWhenFull", "[MRMWQueue]")
+{
+  PBB::MRMWQueue<std::unique_ptr<int>> queue;
+  queue.CapacitySet(2);
+  REQUIRE(queue.TryPush(std::make_unique<int>(0)));
+  REQUIRE(queue.TryPush(std::make_unique<int>(1)));
+
+  // The source is not consumed, when the push fails
+  auto item = std::make_unique<int>(2);
+  REQUIRE_FALSE(queue.TryPush(std::move(item)));
+  REQUIRE(item);
+  REQUIRE_FALSE(queue.TryPushUntil(
+    std::move(item), std::chrono::steady_clock::now() + std::chrono::milliseconds(5)));
+  REQUIRE(item);
+  REQUIRE(queue.Size() == 2);
+
+  std::unique_ptr<int> value;
+  REQUIRE(queue.TryPop(value));
+  REQUIRE(queue.TryPush(std::move(item)));
+}
+
+TEST_CASE("MRMWQueue_Bounded_PushBlocksUntilPopped", "[MRMWQueue]")
+{
+  PBB::MRMWQueue<int> queue;
+  queue.CapacitySet(1);
+  queue.Push(0);
+
+  std::atomic<bool> pushed{ false };
+  std::thread producer(
+    [&]
+    {
+      queue.Push(1);
+      pushed = true;
+    });
+  std::this_thread::sleep_for(std::chrono::milliseconds{ 10 });
+  REQUIRE_FALSE(pushed.load());
+
+  int value = -1;
+  REQUIRE(queue.Pop(value));
+  producer.join();
+  REQUIRE(pushed.load());
+  REQUIRE(queue.Pop(value));
+  REQUIRE(value == 1);
+}
+
+TEST_CASE("MRMWQueue_PopFor_TimesOutWhenEmpty", "[MRMWQueue]")
+{
+  PBB::MRMWQueue<int> queue;
+  int value = -1;
+  const auto start = std::chrono::steady_clock::now();
+  REQUIRE_FALSE(queue.PopFor(value, std::chrono::milliseconds(10)));
+  REQUIRE(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(10));
+  REQUIRE(queue.Valid());
+
+  // The queue is still usable after a timeout
+  queue.Push(1);
+  REQUIRE(queue.PopFor(value, std::chrono::hours::max()));
+  REQUIRE(value == 1);
+}
+
+TEST_CASE("MRMWQueue_PopUntil_WokenByPushAndInvalidate", "[MRMWQueue]")
+{
+  PBB::MRMWQueue<int> queue;
+  std::thread producer(
+    [&]
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds{ 5 });
+      queue.Push(42);
+    });
+  int value = -1;
+  REQUIRE(queue.PopUntil(value, std::chrono::steady_clock::now() + std::chrono::seconds(10)));
+  REQUIRE(value == 42);
+  producer.join();
+
+  std::thread invalidator(
+    [&]
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds{ 5 });
+      queue.Invalidate();
+    });
+  REQUIRE_FALSE(queue.PopFor(value, std::chrono::seconds(10)));
+  invalidator.join();
+}
+
+TEST_CASE("MRMWQueue_TryPushFor_WaitsForRoom", "[MRMWQueue]")
+{
+  PBB::MRMWQueue<int> queue;
+  queue.CapacitySet(1);
+  REQUIRE(queue.TryPushFor(0, std::chrono::milliseconds(1)));
+  REQUIRE_FALSE(queue.TryPushFor(1, std::chrono::milliseconds(5)));
+
+  std::thread consumer(
+    [&]
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds{ 5 });
+      int value = -1;
+      queue.Pop(value);
+    });
+  REQUIRE(queue.TryPushFor(2, std::chrono::seconds(10)));
+  consumer.join();
+}
+
+TEST_CASE("MRMWQueue_Close_RejectsPushesAndDrains", "[MRMWQueue]")
+{
+  PBB::MRMWQueue<std::unique_ptr<int>> queue;
+  queue.Push(std::make_unique<int>(0));
+  queue.Push(std::make_unique<int>(1));
+  queue.Close();
+  REQUIRE(queue.Closed());
+  REQUIRE(queue.Valid());
+
+  auto item = std::make_unique<int>(2);
+  REQUIRE_FALSE(queue.Push(std::move(item)));
+  REQUIRE_FALSE(queue.TryPush(std::move(item)));
+  REQUIRE(item);
+
+  std::unique_ptr<int> value;
+  REQUIRE(queue.Pop(value));
+  REQUIRE(*value == 0);
+  REQUIRE(queue.Pop(value));
+  REQUIRE(*value == 1);
+  // Closed and empty, so no waiting
+  REQUIRE_FALSE(queue.Pop(value));
+}
+
+TEST_CASE("MRMWQueue_Close_WakesWaitingConsumers", "[MRMWQueue]")
+{
+  PBB::MRMWQueue<int> queue;
+  std::thread closer(
+    [&]
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds{ 5 });
+      queue.Close();
+    });
+  int value = -1;
+  REQUIRE_FALSE(queue.Pop(value));
+  closer.join();
+}
+
+TEST_CASE("MRMWQueue_Segments_RecycledAcrossBursts", "[MRMWQueue]")
+{
+  // Bursts spanning several segments, each item destroyed exactly once
+  static std::atomic<int> live{ 0 };
+  struct Counted
+  {
+    Counted() { live++; }
+    explicit Counted(int v)
+      : value(v)
+    {
+      live++;
+    }
+    Counted(Counted&& other) noexcept
+      : value(other.value)
+    {
+      live++;
+    }
+    Counted& operator=(Counted&& other) noexcept
+    {
+      value = other.value;
+      return *this;
+    }
+    ~Counted() { live--; }
+    int value{ -1 };
+  };
+
+  constexpr int nItems = 5 * static_cast<int>(PBB::MRMWQueue<Counted>::SegmentSize) + 3;
+  {
+    PBB::MRMWQueue<Counted, 2> queue;
+    for (int burst = 0; burst < 3; burst++)
+    {
+      for (int i = 0; i < nItems; i++)
+      {
+        REQUIRE(queue.Push(Counted{ i }, static_cast<std::size_t>(burst % 2)));
+      }
+      REQUIRE(queue.Size() == static_cast<std::size_t>(nItems));
+
+      Counted item;
+      bool ordered = true;
+      for (int i = 0; i < nItems; i++)
+      {
+        REQUIRE(queue.TryPop(item));
+        ordered = ordered && item.value == i;
+      }
+      REQUIRE(ordered);
+      REQUIRE(queue.Empty());
+    }
+
+    // Items left in the queue are destroyed by Clear()
+    for (int i = 0; i < nItems; i++)
+    {
+      queue.Push(Counted{ i });
+    }
+    queue.Clear();
+    REQUIRE(live == 0);
+    queue.Push(Counted{ 1 });
+  }
+  REQUIRE(live == 0);
+}
+
+TEST_CASE("MRMWQueue_Pop_SleepingConsumersWokenByPushes", "[MRMWQueue]")
+{
+  // Untimed and timed consumers sleep in different ways
+  PBB::MRMWQueue<int> queue;
+  std::atomic<int> received{ 0 };
+  std::vector<std::thread> consumers;
+  for (int i = 0; i < 4; i++)
+  {
+    consumers.emplace_back(
+      [&, i]
+      {
+        int value = 0;
+        const bool popped =
+          i % 2 == 0 ? queue.Pop(value) : queue.PopFor(value, std::chrono::seconds{ 30 });
+        if (popped)
+        {
+          received += value;
+        }
+      });
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds{ 10 });
+  for (int i = 1; i <= 4; i++)
+  {
+    REQUIRE(queue.Push(int{ i }));
+  }
+  for (auto& consumer : consumers)
+  {
+    consumer.join();
+  }
+  REQUIRE(received == 10);
+}
+
+TEST_CASE("MRMWQueue_Stats_CountsPushesPopsAndPeak", "[MRMWQueue]")
+{
+  PBB::MRMWQueue<int, 2> queue;
+  for (int i = 0; i < 5; i++)
+  {
+    REQUIRE(queue.Push(int{ i }, static_cast<std::size_t>(i % 2)));
+  }
+  int value = 0;
+  REQUIRE(queue.TryPop(value));
+  REQUIRE(queue.TryPop(value));
+
+  const PBB::QueueStats stats = queue.Stats();
+  REQUIRE(stats.depth == 3);
+  if constexpr (PBB::StatsEnabled)
+  {
+    REQUIRE(stats.peakDepth == 5);
+    REQUIRE(stats.pushes == 5);
+    REQUIRE(stats.pops == 2);
+  }
+  else
+  {
+    REQUIRE(stats.peakDepth == 0);
+    REQUIRE(stats.pushes == 0);
+  }
+
+  // A consumer blocked in Pop reports its wait
+  queue.Clear();
+  std::thread consumer([&] { queue.Pop(value); });
+  std::this_thread::sleep_for(std::chrono::milliseconds{ 20 });
+  REQUIRE(queue.Push(int{ 42 }));
+  consumer.join();
+  if constexpr (PBB::StatsEnabled)
+  {
+    REQUIRE(queue.Stats().popWaitTime >= std::chrono::milliseconds{ 10 });
+  }
+}
@@ -1,6 +1,17 @@
+#include <catch2/catch_test_macros.hpp>
+
 #include <PBB/Memory.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
 #include <iostream>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
 
+namespace
+{
 struct Example
 {
   int x;
@@ -13,16 +24,62 @@ struct Example
   ~Example() { std::cout << "Example destroyed\n"; }
 };
 
-int main()
+bool IsAligned(const void* p, std::size_t alignment)
 {
+  return (reinterpret_cast<std::uintptr_t>(p) % alignment) == 0;
+}
+} // namespace
 
+TEST_CASE("CacheAlignedPlacement_ThrowingConstructor_ExceptionPropagated", "[Memory]")
+{
+  bool caught = false;
   try
   {
-    PBB::PaddedPlacement<Example> padded(-1); // Constructor throws!
+    PBB::CacheAlignedPlacement<Example> padded(-1); // Constructor throws!
   }
-  catch (...)
+  catch (const std::runtime_error&)
+  {
+    caught = true;
+  }
+  REQUIRE(caught);
+
+  PBB::CacheAlignedPlacement<Example> valid(3);
+  REQUIRE(valid.get().x == 3);
+  REQUIRE(IsAligned(&valid, PBB::CACHE_LINE_SIZE));
+}
+
+TEST_CASE("CacheAlignedAllocator_Vector_StorageAligned", "[Memory]")
+{
+  std::vector<float, PBB::CacheAlignedAllocator<float>> values(100, 1.0f);
+  REQUIRE(IsAligned(values.data(), PBB::CACHE_LINE_SIZE));
+
+  values.resize(1000, 2.0f);
+  REQUIRE(IsAligned(values.data(), PBB::CACHE_LINE_SIZE));
+  REQUIRE(std::accumulate(values.begin(), values.end(), 0.0f) == 1900.0f);
+
+  std::vector<char, PBB::CacheAlignedAllocator<char, 256>> bytes(10);
+  REQUIRE(IsAligned(bytes.data(), 256));
+}
+
+TEST_CASE("CacheAlignedArray_Elements_OnSeparateCacheLines", "[Memory]")
+{
+  PBB::CacheAlignedArray<int> counters(4, 1);
+  REQUIRE(counters.size() == 4);
+  for (std::size_t i = 0; i < counters.size(); i++)
   {
-    std::cout << "Exception caught!\n";
+    REQUIRE(IsAligned(&counters[i], PBB::CACHE_LINE_SIZE));
   }
-  return 0;
+  const auto stride = reinterpret_cast<std::uintptr_t>(&counters[1]) -
+    reinterpret_cast<std::uintptr_t>(&counters[0]);
+  REQUIRE(stride >= PBB::CACHE_LINE_SIZE);
+
+  counters[2] = 5;
+  REQUIRE(std::accumulate(counters.begin(), counters.end(), 0) == 8);
+
+  // Random access algorithms
+  std::ranges::sort(counters, std::greater<>());
+  REQUIRE(counters[0] == 5);
+  REQUIRE(*(2 + counters.begin()) == 1);
+  REQUIRE(counters.begin() + 1 >= counters.begin());
+  REQUIRE(std::ranges::is_sorted(counters, std::greater<>()));
 }
@@ -0,0 +1,138 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <PBB/OverwriteRing.hpp>
+
+namespace
+{
+// Larger than a word, such that torn reads would be detectable
+struct Sample
+{
+    std::uint64_t index;
+    std::uint64_t check;
+    double value;
+};
+} // namespace
+
+TEST_CASE("OverwriteRing_KeepsLatestItems", "[OverwriteRing]")
+{
+    PBB::OverwriteRing<int> ring(3);
+    REQUIRE(ring.Capacity() == 4);
+
+    auto reader = ring.CreateReader();
+    int value = -1;
+    REQUIRE_FALSE(ring.TryRead(reader, value));
+
+    for (int i = 0; i < 10; i++)
+    {
+        ring.Push(i);
+    }
+    REQUIRE(ring.Published() == 10);
+
+    // Six items were overwritten before the reader got to them
+    for (int i = 6; i < 10; i++)
+    {
+        REQUIRE(ring.TryRead(reader, value));
+        REQUIRE(value == i);
+    }
+    REQUIRE_FALSE(ring.TryRead(reader, value));
+    REQUIRE(reader.Missed() == 6);
+    REQUIRE(reader.Position() == 10);
+}
+
+TEST_CASE("OverwriteRing_CreateReader_StartPosition", "[OverwriteRing]")
+{
+    PBB::OverwriteRing<int> ring(4);
+    for (int i = 0; i < 6; i++)
+    {
+        ring.Push(i);
+    }
+
+    int value = -1;
+    auto newest = ring.CreateReader();
+    REQUIRE_FALSE(ring.TryRead(newest, value));
+
+    auto oldest = ring.CreateReader(true);
+    REQUIRE(ring.TryRead(oldest, value));
+    REQUIRE(value == 2);
+    REQUIRE(oldest.Missed() == 0);
+
+    ring.Push(6);
+    REQUIRE(ring.TryRead(newest, value));
+    REQUIRE(value == 6);
+}
+
+TEST_CASE("OverwriteRing_TryReadLatest_SkipsOlderItems", "[OverwriteRing]")
+{
+    PBB::OverwriteRing<int> ring(8);
+    auto reader = ring.CreateReader();
+    for (int i = 0; i < 5; i++)
+    {
+        ring.Push(i);
+    }
+
+    int value = -1;
+    REQUIRE(ring.TryReadLatest(reader, value));
+    REQUIRE(value == 4);
+    REQUIRE(reader.Missed() == 4);
+    REQUIRE_FALSE(ring.TryReadLatest(reader, value));
+}
+
+TEST_CASE("OverwriteRing_ConcurrentReaders_NoTornItems", "[OverwriteRing]")
+{
+    constexpr std::uint64_t nItems = 200000;
+    constexpr std::size_t nReaders = 3;
+    PBB::OverwriteRing<Sample> ring(64);
+
+    std::vector<char> consistent(nReaders, 0);
+    std::vector<std::uint64_t> accounted(nReaders, 0);
+    std::vector<std::thread> readers;
+    for (std::size_t r = 0; r < nReaders; r++)
+    {
+        readers.emplace_back(
+          [&, r, reader = ring.CreateReader()]() mutable
+          {
+              bool ok = true;
+              std::uint64_t read = 0;
+              std::uint64_t next = 0;
+              Sample sample{};
+              while (reader.Position() < nItems)
+              {
+                  if (!ring.TryRead(reader, sample))
+                  {
+                      std::this_thread::yield();
+                      continue;
+                  }
+                  // Items are whole and in order
+                  ok = ok && sample.check == ~sample.index &&
+                    sample.value == static_cast<double>(sample.index) && sample.index >= next;
+                  next = sample.index + 1;
+                  read++;
+              }
+              consistent[r] = ok ? 1 : 0;
+              accounted[r] = read + reader.Missed();
+          });
+    }
+
+    for (std::uint64_t i = 0; i < nItems; i++)
+    {
+        ring.Push(Sample{ i, ~i, static_cast<double>(i) });
+        if (i % 1024 == 0)
+        {
+            std::this_thread::yield();
+        }
+    }
+    for (auto& thread : readers)
+    {
+        thread.join();
+    }
+
+    for (std::size_t r = 0; r < nReaders; r++)
+    {
+        REQUIRE(consistent[r] == 1);
+        REQUIRE(accounted[r] == nItems);
+    }
+}
@@ -0,0 +1,115 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <PBB/MRMWQueue.hpp>
+#include <PBB/Probes.hpp>
+#include <PBB/ThreadPool.hpp>
+#include <PBB/ThreadPoolCustom.hpp>
+
+#ifdef __linux__
+#include <elf.h>
+#include <link.h>
+#endif
+
+using namespace PBB::Thread;
+namespace
+{
+#ifdef __linux__
+// Append the "provider:name" of each SDT note in an ELF file
+void ReadProbes(const std::string& path, std::set<std::string>& probes)
+{
+    std::ifstream file(path, std::ios::binary);
+    std::vector<char> image((std::istreambuf_iterator<char>(file)), {});
+    if (image.size() < sizeof(Elf64_Ehdr) || std::memcmp(image.data(), ELFMAG, SELFMAG) != 0 ||
+      image[EI_CLASS] != ELFCLASS64)
+    {
+        return;
+    }
+    Elf64_Ehdr header;
+    std::memcpy(&header, image.data(), sizeof(header));
+    for (std::size_t i = 0; i < header.e_shnum; i++)
+    {
+        Elf64_Shdr section;
+        const std::size_t offset = header.e_shoff + i * header.e_shentsize;
+        if (offset + sizeof(section) > image.size())
+        {
+            return;
+        }
+        std::memcpy(&section, image.data() + offset, sizeof(section));
+        if (section.sh_type != SHT_NOTE || section.sh_offset + section.sh_size > image.size())
+        {
+            continue;
+        }
+        std::size_t position = section.sh_offset;
+        const std::size_t end = section.sh_offset + section.sh_size;
+        while (position + sizeof(Elf64_Nhdr) <= end)
+        {
+            Elf64_Nhdr note;
+            std::memcpy(&note, image.data() + position, sizeof(note));
+            const char* pName = image.data() + position + sizeof(note);
+            const char* pDesc = pName + ((note.n_namesz + 3) & ~3u);
+            if (note.n_type == 3 && note.n_namesz == sizeof("stapsdt") &&
+              std::strcmp(pName, "stapsdt") == 0 && note.n_descsz > 3 * sizeof(std::uint64_t))
+            {
+                // Addresses of the probe, the base and the semaphore,
+                // followed by the provider and the probe name
+                const char* pProvider = pDesc + 3 * sizeof(std::uint64_t);
+                const char* pProbe = pProvider + std::strlen(pProvider) + 1;
+                probes.insert(std::string(pProvider) + ":" + pProbe);
+            }
+            position = static_cast<std::size_t>(pDesc - image.data()) + ((note.n_descsz + 3) & ~3u);
+        }
+    }
+}
+#endif
+
+// Probes of the executable and the loaded shared libraries
+std::set<std::string> LoadedProbes()
+{
+    std::set<std::string> probes;
+#ifdef __linux__
+    std::vector<std::string> paths;
+    dl_iterate_phdr(
+      [](dl_phdr_info* pInfo, std::size_t, void* pData)
+      {
+          auto& paths = *static_cast<std::vector<std::string>*>(pData);
+          paths.emplace_back(
+            pInfo->dlpi_name && pInfo->dlpi_name[0] ? pInfo->dlpi_name : "/proc/self/exe");
+          return 0;
+      },
+      &paths);
+    for (const auto& path : paths)
+    {
+        ReadProbes(path, probes);
+    }
+#endif
+    return probes;
+}
+} // namespace
+
+TEST_CASE("Probes_ElfNotes_TaskLifecycleAndQueue", "[Probes]")
+{
+    // Instantiate the probed templates in this binary
+    PBB::MRMWQueue<int> queue;
+    queue.Push(1);
+    int item = 0;
+    REQUIRE(queue.Pop(item));
+    auto& customPool = ThreadPool<Tags::CustomPool>::InstanceGet();
+    REQUIRE(customPool.Submit([]() { return 1; }, nullptr).Get() == 1);
+    auto& defaultPool = ThreadPool<Tags::DefaultPool>::InstanceGet();
+    defaultPool.Submit([]() noexcept -> void {}, nullptr).Get();
+
+    const std::set<std::string> probes = LoadedProbes();
+    for (const char* name : { "task_submit", "task_rejected", "task_dequeue", "task_start",
+           "task_end", "init_start", "init_end", "queue_block", "queue_unblock" })
+    {
+        INFO(name);
+        REQUIRE(probes.count(std::string("pbb:") + name) == (PBB::ProbesEnabled ? 1u : 0u));
+    }
+}
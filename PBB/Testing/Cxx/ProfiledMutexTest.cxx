@@ -0,0 +1,154 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <PBB/ProfiledMutex.hpp>
+#include <PBB/ThreadLocal.hpp>
+#include <PBB/ThreadPool.hpp>
+#include <PBB/ThreadPoolTags.hpp>
+
+namespace
+{
+PBB::LockProfile ProfileGet(const std::string& name)
+{
+    const std::vector<PBB::LockProfile> profiles = PBB::LockProfiles();
+    auto it = std::find_if(profiles.begin(), profiles.end(),
+      [&name](const PBB::LockProfile& profile) { return profile.name == name; });
+    return it == profiles.end() ? PBB::LockProfile{} : *it;
+}
+} // namespace
+
+TEST_CASE("ProfiledMutex_ContendedLock_MeasuresWaitAndHold", "[ProfiledMutex]")
+{
+    using namespace std::chrono_literals;
+    PBB::detail::v20::ProfiledMutex<std::mutex, "ProfiledMutexTest::exclusive"> mutex;
+    PBB::LockProfilesReset();
+
+    std::atomic<bool> locking{ false };
+    mutex.lock();
+    std::thread waiter(
+      [&]()
+      {
+          locking.store(true);
+          std::lock_guard guard(mutex);
+      });
+    while (!locking.load())
+    {
+        std::this_thread::yield();
+    }
+    std::this_thread::sleep_for(20ms);
+    mutex.unlock();
+    waiter.join();
+
+    REQUIRE(mutex.try_lock());
+    mutex.unlock();
+
+    const PBB::LockProfile profile = ProfileGet("ProfiledMutexTest::exclusive");
+    REQUIRE(profile.acquisitions == 3);
+    REQUIRE(profile.shared == 0);
+    REQUIRE(profile.contended == 1);
+    REQUIRE(profile.waitTime >= 10ms);
+    REQUIRE(profile.maxWait == profile.waitTime);
+    REQUIRE(profile.holdTime >= 20ms);
+
+    std::ostringstream report;
+    PBB::WriteLockProfiles(report, { profile });
+    REQUIRE(report.str().find("ProfiledMutexTest::exclusive") != std::string::npos);
+
+    PBB::LockProfilesReset();
+    REQUIRE(ProfileGet("ProfiledMutexTest::exclusive").acquisitions == 0);
+}
+
+TEST_CASE("ProfiledMutex_SharedLocksAndConditionVariable", "[ProfiledMutex]")
+{
+    PBB::detail::v20::ProfiledMutex<std::shared_mutex, "ProfiledMutexTest::shared"> mutex;
+    PBB::LockProfilesReset();
+    {
+        std::shared_lock first(mutex);
+        std::shared_lock second(mutex);
+        REQUIRE(!mutex.try_lock());
+    }
+    {
+        std::unique_lock lock(mutex);
+        REQUIRE(!mutex.try_lock_shared());
+    }
+    PBB::LockProfile profile = ProfileGet("ProfiledMutexTest::shared");
+    REQUIRE(profile.acquisitions == 3);
+    REQUIRE(profile.shared == 2);
+    REQUIRE(profile.contended == 0);
+
+    // Waiting releases and reacquires the lock through the wrapper
+    PBB::detail::v20::ProfiledMutex<std::mutex, "ProfiledMutexTest::condition"> conditionMutex;
+    std::condition_variable_any condition;
+    bool ready = false;
+    std::thread notifier(
+      [&]()
+      {
+          std::lock_guard guard(conditionMutex);
+          ready = true;
+          condition.notify_one();
+      });
+    {
+        std::unique_lock lock(conditionMutex);
+        condition.wait(lock, [&]() { return ready; });
+    }
+    notifier.join();
+    REQUIRE(ProfileGet("ProfiledMutexTest::condition").acquisitions >= 2);
+}
+
+TEST_CASE("ProfiledMutex_InternalLocks_ReportedByName", "[ProfiledMutex]")
+{
+    // The standard types, unless PBB_PROFILE_LOCKS
+    constexpr bool profiled = PBB::LockProfilingEnabled;
+    STATIC_REQUIRE(std::is_same_v<PBB::Mutex<"Unused">, std::mutex> != profiled);
+    STATIC_REQUIRE(std::is_same_v<PBB::SharedMutex<"Unused">, std::shared_mutex> != profiled);
+    STATIC_REQUIRE(std::is_same_v<PBB::ConditionVariable, std::condition_variable> != profiled);
+
+    // Accessors of internal locks keep the standard type
+    STATIC_REQUIRE(std::is_same_v<decltype(std::declval<PBB::ThreadLocal<int>&>().GetMutex()),
+      std::mutex&>);
+    if (!profiled)
+    {
+        return;
+    }
+
+    PBB::ThreadLocal<int> values;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++)
+    {
+        threads.emplace_back([&values]() { values.Local()++; });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    REQUIRE(values.Combine(std::plus<int>()) == 4);
+    REQUIRE(ProfileGet("ThreadLocal::_storagemutex").acquisitions >= 4);
+    REQUIRE(ProfileGet("ThreadLocal::_registry_mutex").acquisitions >= 4);
+    {
+        // Excludes the profiled registry mutex, but is not profiled itself
+        std::lock_guard<std::mutex> guard(values.GetMutex());
+        REQUIRE(ProfileGet("ThreadLocal::_registry_mutex").acquisitions >= 4);
+    }
+
+    auto& pool = PBB::Thread::ThreadPool<PBB::Thread::Tags::DefaultPool>::InstanceGet();
+    pool.Submit([]() noexcept -> void {}, nullptr).Get();
+    REQUIRE(ProfileGet("TaskCacheRegistry::m_mutex").acquisitions > 0);
+#ifdef PBB_USE_TBB_QUEUE
+    REQUIRE(ProfileGet("ThreadPool::m_mutex").acquisitions > 0);
+#else
+    REQUIRE(ProfileGet("MRMWQueue::m_mutex").acquisitions > 0);
+#endif
+}
@@ -0,0 +1,116 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include <PBB/SPSCRing.hpp>
+
+TEST_CASE("SPSCRing_Capacity_RoundedToPowerOfTwo", "[SPSCRing]")
+{
+    PBB::SPSCRing<int> ring(5);
+    REQUIRE(ring.Capacity() == 8);
+    for (int i = 0; i < 8; i++)
+    {
+        REQUIRE(ring.TryPush(i));
+    }
+    REQUIRE_FALSE(ring.TryPush(8));
+    REQUIRE(ring.SizeGet() == 8);
+
+    int value = -1;
+    for (int i = 0; i < 8; i++)
+    {
+        REQUIRE(ring.TryPop(value));
+        REQUIRE(value == i);
+    }
+    REQUIRE_FALSE(ring.TryPop(value));
+    REQUIRE(ring.Empty());
+}
+
+TEST_CASE("SPSCRing_Batch_PartialWhenFull", "[SPSCRing]")
+{
+    PBB::SPSCRing<std::unique_ptr<int>> ring(4);
+    std::vector<std::unique_ptr<int>> items;
+    for (int i = 0; i < 6; i++)
+    {
+        items.push_back(std::make_unique<int>(i));
+    }
+    REQUIRE(ring.TryPushBatch(items.begin(), items.size()) == 4);
+    REQUIRE(items[4]);
+
+    std::vector<std::unique_ptr<int>> popped(6);
+    REQUIRE(ring.TryPopBatch(popped.begin(), popped.size()) == 4);
+    for (int i = 0; i < 4; i++)
+    {
+        REQUIRE(*popped[static_cast<std::size_t>(i)] == i);
+    }
+}
+
+TEST_CASE("SPSCRing_ReserveCommit_WritesInPlace", "[SPSCRing]")
+{
+    // Frames keep their buffers when written in place
+    PBB::SPSCRing<std::vector<float>> ring(2);
+    std::vector<float>* pFrame = ring.Reserve();
+    REQUIRE(pFrame != nullptr);
+    pFrame->assign(1024, 1.0f);
+    const float* pData = pFrame->data();
+    ring.Commit();
+
+    std::vector<float>* pRead = ring.Peek();
+    REQUIRE(pRead == pFrame);
+    REQUIRE(pRead->size() == 1024);
+    ring.Consume();
+    REQUIRE(ring.Peek() == nullptr);
+
+    // Write and read the second slot, then wrap around to the first
+    REQUIRE(ring.Reserve() != pFrame);
+    ring.Commit();
+    REQUIRE(ring.Peek() != nullptr);
+    ring.Consume();
+
+    pFrame = ring.Reserve();
+    REQUIRE(pFrame->data() == pData);
+}
+
+TEST_CASE("SPSCRing_TwoThreads_PreservesOrder", "[SPSCRing]")
+{
+    constexpr std::uint64_t nItems = 1000000;
+    PBB::SPSCRing<std::uint64_t> ring(1024);
+
+    std::thread producer(
+      [&]
+      {
+          std::uint64_t next = 0;
+          std::uint64_t batch[16];
+          while (next < nItems)
+          {
+              if (next % 3 == 0)
+              {
+                  std::iota(std::begin(batch), std::end(batch), next);
+                  const std::size_t count = std::min<std::uint64_t>(16, nItems - next);
+                  next += ring.TryPushBatch(std::begin(batch), count);
+              }
+              else if (ring.TryPush(next))
+              {
+                  next++;
+              }
+          }
+      });
+
+    std::uint64_t expected = 0;
+    bool ordered = true;
+    std::uint64_t batch[16];
+    while (expected < nItems)
+    {
+        const std::size_t count = ring.TryPopBatch(std::begin(batch), 16);
+        for (std::size_t i = 0; i < count; i++)
+        {
+            ordered = ordered && batch[i] == expected++;
+        }
+    }
+    producer.join();
+    REQUIRE(ordered);
+    REQUIRE(ring.Empty());
+}
@@ -0,0 +1,134 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <PBB/ShardedMRMWQueue.hpp>
+
+using namespace std::chrono_literals;
+
+TEST_CASE("ShardedMRMWQueue_PushPop_NoErrors", "[ShardedMRMWQueue]")
+{
+    PBB::ShardedMRMWQueue<std::unique_ptr<int>> queue(4);
+    REQUIRE(queue.NShardsGet() == 4);
+
+    // A single thread pushes to and pops from its home shard in order
+    for (int i = 0; i < 10; i++)
+    {
+        REQUIRE(queue.Push(std::make_unique<int>(i)));
+    }
+    REQUIRE(queue.Size() == 10);
+
+    std::unique_ptr<int> item;
+    for (int i = 0; i < 10; i++)
+    {
+        REQUIRE(queue.TryPop(item));
+        REQUIRE(*item == i);
+    }
+    REQUIRE_FALSE(queue.TryPop(item));
+    REQUIRE(queue.Empty());
+}
+
+TEST_CASE("ShardedMRMWQueue_Bounded_SpillsToOtherShards", "[ShardedMRMWQueue]")
+{
+    PBB::ShardedMRMWQueue<int> queue(2);
+    queue.CapacitySet(4);
+    REQUIRE(queue.CapacityGet() == 4);
+
+    // The home shard holds two items, the remaining go elsewhere
+    for (int i = 0; i < 4; i++)
+    {
+        REQUIRE(queue.TryPush(int{ i }));
+    }
+    int item = 4;
+    REQUIRE_FALSE(queue.TryPush(std::move(item)));
+    REQUIRE_FALSE(queue.TryPushFor(std::move(item), 10ms));
+    REQUIRE(item == 4);
+    REQUIRE(queue.Size() == 4);
+}
+
+TEST_CASE("ShardedMRMWQueue_PopFor_TimesOutAndWakes", "[ShardedMRMWQueue]")
+{
+    PBB::ShardedMRMWQueue<int> queue(4);
+    int item = 0;
+    REQUIRE_FALSE(queue.PopFor(item, 10ms));
+
+    std::thread producer(
+      [&]
+      {
+          std::this_thread::sleep_for(10ms);
+          queue.Push(42);
+      });
+    REQUIRE(queue.PopFor(item, std::chrono::seconds(10)));
+    REQUIRE(item == 42);
+    producer.join();
+}
+
+TEST_CASE("ShardedMRMWQueue_Close_DrainsThenWakesConsumers", "[ShardedMRMWQueue]")
+{
+    PBB::ShardedMRMWQueue<int> queue(4);
+    REQUIRE(queue.Push(1));
+    queue.Close();
+    REQUIRE(queue.Closed());
+    REQUIRE_FALSE(queue.Push(2));
+
+    int item = 0;
+    REQUIRE(queue.Pop(item));
+    REQUIRE(item == 1);
+    REQUIRE_FALSE(queue.Pop(item));
+}
+
+TEST_CASE("ShardedMRMWQueue_ManyProducersConsumers_NoLostItems", "[ShardedMRMWQueue]")
+{
+    constexpr std::size_t nThreads = 4;
+    constexpr std::uint64_t nItemsPerProducer = 20000;
+    PBB::ShardedMRMWQueue<std::uint64_t, 2> queue(nThreads);
+
+    std::vector<std::uint64_t> sums(nThreads, 0);
+    std::vector<std::thread> consumers;
+    for (std::size_t c = 0; c < nThreads; c++)
+    {
+        consumers.emplace_back(
+          [&, c]
+          {
+              std::uint64_t item = 0;
+              while (queue.Pop(item))
+              {
+                  sums[c] += item;
+              }
+          });
+    }
+
+    std::vector<std::thread> producers;
+    for (std::size_t p = 0; p < nThreads; p++)
+    {
+        producers.emplace_back(
+          [&]
+          {
+              for (std::uint64_t i = 1; i <= nItemsPerProducer; i++)
+              {
+                  queue.Push(std::uint64_t{ i }, i % 2);
+              }
+          });
+    }
+    for (auto& thread : producers)
+    {
+        thread.join();
+    }
+    queue.Close();
+    for (auto& thread : consumers)
+    {
+        thread.join();
+    }
+
+    std::uint64_t total = 0;
+    for (const auto sum : sums)
+    {
+        total += sum;
+    }
+    REQUIRE(total == nThreads * nItemsPerProducer * (nItemsPerProducer + 1) / 2);
+    REQUIRE(queue.Empty());
+}
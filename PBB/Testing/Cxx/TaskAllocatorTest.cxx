@@ -0,0 +1,144 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "PBB/ThreadPool.hpp"
+#include "PBB/ThreadPoolCustom.hpp"
+#include "PBB/ThreadPoolTags.hpp"
+#include <PBB/TaskAllocator.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using PBB::Thread::TaskAllocator;
+using PBB::Thread::TaskMemory;
+
+TEST_CASE("TaskMemory_SizeClasses_AlignedAndWritable", "[TaskAllocator]")
+{
+    std::vector<void*> blocks;
+    for (std::size_t size : { 1, 16, 48, 100, 500, 2000, 5000, 100000 })
+    {
+        void* p = TaskMemory::Allocate(size, alignof(std::max_align_t));
+        REQUIRE(p != nullptr);
+        REQUIRE(reinterpret_cast<std::uintptr_t>(p) % alignof(std::max_align_t) == 0);
+        std::memset(p, 0xab, size);
+        blocks.push_back(p);
+    }
+    for (void* p : blocks)
+    {
+        TaskMemory::Deallocate(p);
+    }
+}
+
+TEST_CASE("TaskMemory_OverAligned_FallsBackToHeap", "[TaskAllocator]")
+{
+    void* p = TaskMemory::Allocate(64, 128);
+    REQUIRE(reinterpret_cast<std::uintptr_t>(p) % 128 == 0);
+    TaskMemory::Deallocate(p);
+}
+
+TEST_CASE("TaskMemory_SameThread_ReusesBlocks", "[TaskAllocator]")
+{
+#ifdef PBB_USE_TASK_POOL
+    void* p = TaskMemory::Allocate(32, 8);
+    TaskMemory::Deallocate(p);
+    void* q = TaskMemory::Allocate(32, 8);
+    REQUIRE(p == q);
+    TaskMemory::Deallocate(q);
+#else
+    SUCCEED("Task pool disabled");
+#endif
+}
+
+TEST_CASE("TaskMemory_RemoteFrees_ReturnToOwner", "[TaskAllocator]")
+{
+    // Allocate on this thread, free on others, which batch the blocks back
+    constexpr std::size_t nBlocks = 4096;
+    for (int round = 0; round < 4; round++)
+    {
+        std::vector<void*> blocks(nBlocks);
+        for (auto& p : blocks)
+        {
+            p = TaskMemory::Allocate(40, 8);
+            std::memset(p, round, 40);
+        }
+        std::thread t1(
+          [&]
+          {
+              for (std::size_t i = 0; i < nBlocks / 2; i++)
+                  TaskMemory::Deallocate(blocks[i]);
+          });
+        std::thread t2(
+          [&]
+          {
+              for (std::size_t i = nBlocks / 2; i < nBlocks; i++)
+                  TaskMemory::Deallocate(blocks[i]);
+          });
+        t1.join();
+        t2.join();
+    }
+}
+
+TEST_CASE("TaskMemory_ExitedThread_CacheAdopted", "[TaskAllocator]")
+{
+    // Blocks allocated by an exited thread can still be freed
+    void* p = nullptr;
+    std::thread([&] { p = TaskMemory::Allocate(24, 8); }).join();
+    TaskMemory::Deallocate(p);
+    std::thread(
+      [&]
+      {
+          void* q = TaskMemory::Allocate(24, 8);
+          TaskMemory::Deallocate(q);
+      })
+      .join();
+}
+
+TEST_CASE("TaskAllocator_AllocateShared_Works", "[TaskAllocator]")
+{
+    auto p = std::allocate_shared<std::vector<int>>(TaskAllocator<int>{}, 100, 7);
+    REQUIRE(p->size() == 100);
+    std::promise<int> promise(std::allocator_arg, TaskAllocator<int>{});
+    auto future = promise.get_future();
+    std::thread([&] { promise.set_value(42); }).join();
+    REQUIRE(future.get() == 42);
+}
+
+TEST_CASE("TaskAllocator_ThreadPool_SubmitFromManyThreads", "[TaskAllocator]")
+{
+    using PBB::Thread::ThreadPool;
+    auto& pool = ThreadPool<PBB::Thread::Tags::DefaultPool>::InstanceGet();
+    std::vector<std::thread> producers;
+    std::atomic<int> sum{ 0 };
+    for (int t = 0; t < 4; t++)
+    {
+        producers.emplace_back(
+          [&, t]
+          {
+              std::vector<PBB::Thread::TaskFuture<int>> futures;
+              for (int i = 0; i < 1000; i++)
+              {
+                  futures.push_back(pool.Submit([t]() noexcept { return t; }, nullptr));
+              }
+              for (auto& future : futures)
+              {
+                  sum += future.Get();
+              }
+          });
+    }
+    for (auto& producer : producers)
+    {
+        producer.join();
+    }
+    REQUIRE(sum.load() == 1000 * (0 + 1 + 2 + 3));
+}
+
+TEST_CASE("TaskAllocator_CustomPool_ExceptionPropagated", "[TaskAllocator]")
+{
+    using PBB::Thread::ThreadPool;
+    auto& pool = ThreadPool<PBB::Thread::Tags::CustomPool>::InstanceGet();
+    auto future = pool.Submit([]() -> int { throw std::runtime_error("boom"); }, nullptr);
+    REQUIRE_THROWS_AS(future.Get(), std::runtime_error);
+}
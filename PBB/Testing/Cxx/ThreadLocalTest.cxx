@@ -4,17 +4,202 @@
 #include "PBB/ThreadPoolTags.hpp"
 #include <PBB/ThreadLocal.hpp>
 
+#include <cstdint>
 #include <iostream>
 #include <mutex>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#ifdef PBB_USE_NUMA
+#include <numa.h>
+#include <numaif.h>
+#include <unistd.h>
+#endif
 
 namespace
 {
+struct NoDefault
+{
+    explicit NoDefault(int v)
+      : value(v)
+    {
+    }
+    int value;
+};
+
+struct NonMovable
+{
+    NonMovable() = default;
+    NonMovable(NonMovable&&) = delete;
+    int value{ 1 };
+};
 
+template <typename Func>
+void RunInThreads(std::size_t nThreads, Func&& func)
+{
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < nThreads; i++)
+    {
+        threads.emplace_back(func, static_cast<int>(i));
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+}
 } // namespace
 
 TEST_CASE("PlaceHolder", "[ThreadLocal]")
 {
     REQUIRE(true);
 }
+
+TEST_CASE("ThreadLocal_Combine_SumsAllThreads", "[ThreadLocal]")
+{
+    PBB::ThreadLocal<int> partialSums;
+    RunInThreads(4, [&](int i) { partialSums.Local() += i + 1; });
+
+    REQUIRE(partialSums.Size() == 4);
+    REQUIRE(partialSums.Combine([](int a, int b) { return a + b; }) == 10);
+}
+
+TEST_CASE("ThreadLocal_Combine_EmptyReturnsInitialValue", "[ThreadLocal]")
+{
+    PBB::ThreadLocal<int> defaulted;
+    REQUIRE(defaulted.Combine([](int a, int b) { return a + b; }) == 0);
+
+    PBB::ThreadLocal<int> exemplar(42);
+    REQUIRE(exemplar.Combine([](int a, int b) { return a + b; }) == 42);
+}
+
+TEST_CASE("ThreadLocal_CombineEach_VisitsAllValues", "[ThreadLocal]")
+{
+    PBB::ThreadLocal<std::vector<int>> values;
+    RunInThreads(3,
+      [&](int i)
+      {
+          values.Local().push_back(i);
+          values.Local().push_back(i);
+      });
+
+    std::size_t nValues = 0;
+    values.CombineEach([&](const std::vector<int>& local) { nValues += local.size(); });
+    REQUIRE(nValues == 6);
+
+    // Lock-free iteration once the parallel phase is over
+    std::size_t nIterated = 0;
+    for (const auto& local : values)
+    {
+        nIterated += local.size();
+    }
+    REQUIRE(nIterated == 6);
+}
+
+TEST_CASE("ThreadLocal_Clear_KeepsAllocations", "[ThreadLocal]")
+{
+    PBB::ThreadLocal<int> counters(7);
+    int* pLocal = &counters.Local();
+    *pLocal = 100;
+
+    counters.Clear();
+    REQUIRE(counters.Size() == 1);
+    REQUIRE(&counters.Local() == pLocal);
+    REQUIRE(*pLocal == 7);
+}
+
+TEST_CASE("ThreadLocal_Factory_NoDefaultConstructor", "[ThreadLocal]")
+{
+    PBB::ThreadLocal<NoDefault> fromFactory([]() { return NoDefault(3); });
+    RunInThreads(2, [&](int) { fromFactory.Local().value += 1; });
+    auto combined = fromFactory.Combine(
+      [](const NoDefault& a, const NoDefault& b) { return NoDefault(a.value + b.value); });
+    REQUIRE(combined.value == 8);
+
+    PBB::ThreadLocal<NoDefault> fromExemplar(NoDefault(5));
+    REQUIRE(fromExemplar.Local().value == 5);
+}
+
+TEST_CASE("ThreadLocal_NonMovable_OnlyDefaultConstructed", "[ThreadLocal]")
+{
+    // A factory or exemplar cannot initialize a non-movable value
+    STATIC_REQUIRE(std::is_default_constructible_v<PBB::ThreadLocal<NonMovable>>);
+    STATIC_REQUIRE(!std::is_constructible_v<PBB::ThreadLocal<NonMovable>, NonMovable (*)()>);
+    STATIC_REQUIRE(!std::is_constructible_v<PBB::ThreadLocal<NonMovable>, const NonMovable&>);
+
+    PBB::ThreadLocal<NonMovable> values;
+    REQUIRE(values.Local().value == 1);
+}
+
+TEST_CASE("ThreadLocal_TwoInstances_RegisterIndependently", "[ThreadLocal]")
+{
+    PBB::ThreadLocal<int> first;
+    PBB::ThreadLocal<int> second;
+    first.Local() = 1;
+    second.Local() = 2;
+    REQUIRE(first.Size() == 1);
+    REQUIRE(second.Size() == 1);
+    REQUIRE(second.Combine([](int a, int b) { return a + b; }) == 2);
+}
+
+#ifdef PBB_USE_NUMA
+TEST_CASE("ThreadLocal_NumaPlacement_SlotOnLocalNode", "[ThreadLocal]")
+{
+    if (numa_available() < 0)
+    {
+        SKIP("NUMA not available");
+    }
+
+    const auto pageSize = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+    const int maxNode = numa_max_node();
+
+    PBB::ThreadLocal<long> counters;
+    std::vector<int> expected(static_cast<std::size_t>(maxNode + 1), -1);
+    std::vector<int> actual(static_cast<std::size_t>(maxNode + 1), -1);
+
+    for (int node = 0; node <= maxNode; node++)
+    {
+        if (!numa_bitmask_isbitset(numa_all_nodes_ptr, static_cast<unsigned int>(node)))
+        {
+            continue;
+        }
+        std::thread worker(
+          [&, node]()
+          {
+              // Pin to the node before the slot is created
+              if (numa_run_on_node(node) != 0)
+              {
+                  return;
+              }
+              long& value = counters.Local();
+              value = 1;
+              void* page = reinterpret_cast<void*>(
+                reinterpret_cast<std::uintptr_t>(&value) & ~(pageSize - 1));
+              int status = -1;
+              if (move_pages(0, 1, &page, nullptr, &status, 0) == 0)
+              {
+                  expected[static_cast<std::size_t>(node)] = node;
+                  actual[static_cast<std::size_t>(node)] = status;
+              }
+          });
+        worker.join();
+    }
+
+    // Nodes, which could not be pinned or queried, are not checked
+    std::size_t nChecked = 0;
+    for (std::size_t node = 0; node < expected.size(); node++)
+    {
+        if (expected[node] >= 0)
+        {
+            REQUIRE(actual[node] == expected[node]);
+            nChecked++;
+        }
+    }
+    if (nChecked == 0)
+    {
+        SKIP("Could not pin a thread to a node or query the node of a page");
+    }
+}
+#endif
@@ -1,10 +1,13 @@
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/matchers/catch_matchers_string.hpp>
 
+#include <atomic>
 #include <chrono>
+#include <mutex>
 #include <sstream>
 #include <thread>
 #include <unordered_set>
+#include <vector>
 
 #include <PBB/Config.h>
 #include <PBB/ThreadPool.hpp>
@@ -170,3 +173,106 @@ TEST_CASE("ThreadPool_InitializeExceptionIsPropagated", "[ThreadPoolCustom]")
     REQUIRE(correct_type);
     pool.RemoveInitialize(call_key);
 }
+
+TEST_CASE("ThreadPool_Watchdog_ReportsHangingInitializer", "[ThreadPoolCustom]")
+{
+    using namespace std::chrono_literals;
+    int key = 0;
+    auto& pool = ThreadPool<Tags::CustomPool>::InstanceGet();
+    pool.RegisterInitialize(&key, [] { std::this_thread::sleep_for(200ms); });
+
+    std::mutex mutex;
+    std::vector<StallReport> reports;
+    pool.WatchdogStart(40ms,
+      [&](const StallReport& report)
+      {
+          std::lock_guard<std::mutex> guard(mutex);
+          reports.push_back(report);
+      });
+
+    auto future = pool.Submit([] {}, &key);
+    // Wait for a worker to pick up the task
+    bool initializing = false;
+    const auto deadline = std::chrono::steady_clock::now() + 150ms;
+    while (!initializing && std::chrono::steady_clock::now() < deadline)
+    {
+        for (const WorkerActivity& worker : pool.StateGet().workers)
+        {
+            initializing = initializing ||
+              (worker.state == WorkerState::Initializing && worker.key == &key);
+        }
+        std::this_thread::sleep_for(1ms);
+    }
+    REQUIRE(initializing);
+    std::ostringstream dump;
+    pool.DumpState(dump);
+    REQUIRE(dump.str().find("initializing") != std::string::npos);
+
+    future.Get();
+    pool.WatchdogStop();
+    pool.RemoveInitialize(&key);
+
+    std::lock_guard<std::mutex> guard(mutex);
+    REQUIRE(!reports.empty());
+    REQUIRE(reports.front().kind == StallKind::Initializer);
+    REQUIRE(reports.front().key == &key);
+    REQUIRE(reports.front().duration >= 40ms);
+}
+
+namespace
+{
+thread_local bool keyInitialized = false;
+}
+
+TEST_CASE("ThreadPool_CallerRuns_RejectsTasksNeedingInitialize", "[ThreadPoolCustom]")
+{
+    auto& pool = ThreadPool<Tags::CustomPool>::InstanceGet();
+    const std::size_t nThreads = pool.NThreadsGet();
+    int key = 0;
+    pool.RegisterInitialize(&key, [] { keyInitialized = true; });
+
+    // Occupy every worker, such that the queue fills up
+    std::atomic<std::size_t> started{ 0 };
+    std::atomic<bool> release{ false };
+    std::vector<TaskFuture<void>> blockers;
+    for (std::size_t i = 0; i < nThreads; i++)
+    {
+        blockers.push_back(pool.Submit(
+          [&]()
+          {
+              started++;
+              while (!release.load())
+              {
+                  std::this_thread::yield();
+              }
+          },
+          nullptr));
+    }
+    while (started.load() != nThreads)
+    {
+        std::this_thread::yield();
+    }
+
+    pool.QueueCapacitySet(1, RejectionPolicy::CallerRuns);
+    std::vector<TaskFuture<bool>> futures;
+    for (int i = 0; i < 3; i++)
+    {
+        futures.push_back(pool.Submit([]() { return keyInitialized; }, &key));
+    }
+    // Tasks without an initialization function still run on the caller
+    auto inlined = pool.Submit([]() { return std::this_thread::get_id(); }, nullptr);
+    REQUIRE(inlined.Get() == std::this_thread::get_id());
+
+    release.store(true);
+    for (auto& blocker : blockers)
+    {
+        blocker.Get();
+    }
+    REQUIRE(futures[0].Get());
+    REQUIRE_THROWS_AS(futures[1].Get(), QueueFullError);
+    REQUIRE_THROWS_AS(futures[2].Get(), QueueFullError);
+    REQUIRE(!keyInitialized);
+
+    pool.QueueCapacitySet(0);
+    pool.RemoveInitialize(&key);
+}
@@ -1,11 +1,20 @@
 #include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
 #include <catch2/matchers/catch_matchers_string.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
 #include <sstream>
 #include <thread>
 #include <unordered_set>
+#include <vector>
 
+#include <PBB/MRMWQueue.hpp>
+#include <PBB/Memory.hpp>
 #include <PBB/ThreadPool.hpp>
 #include <PBB/ThreadPoolCustom.hpp>
 
@@ -47,6 +56,54 @@ int longTask()
     return 1;
 }
 
+/**
+ * Occupies all workers of a pool until released, such that subsequently
+ * submitted tasks stay queued.
+ */
+class WorkerBlocker
+{
+  public:
+    template <typename Pool>
+    explicit WorkerBlocker(Pool& pool)
+    {
+        const std::size_t nThreads = pool.NThreadsGet();
+        for (std::size_t i = 0; i < nThreads; i++)
+        {
+            m_futures.push_back(pool.Submit(
+              [this]() noexcept -> void
+              {
+                  m_started++;
+                  while (!m_release.load())
+                  {
+                      std::this_thread::yield();
+                  }
+              },
+              nullptr));
+        }
+        while (m_started.load() != nThreads)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    ~WorkerBlocker() { Release(); }
+
+    void Release()
+    {
+        m_release.store(true);
+        for (auto& future : m_futures)
+        {
+            future.Get();
+        }
+        m_futures.clear();
+    }
+
+  private:
+    std::atomic<std::size_t> m_started{ 0 };
+    std::atomic<bool> m_release{ false };
+    std::vector<TaskFuture<void>> m_futures;
+};
+
 }
 
 /**
@@ -116,3 +173,558 @@ TEST_CASE("ThreadPool_No_Starvation_Detached", "[ThreadPool]")
     REQUIRE(longTaskExecuted == 1);
     REQUIRE(shortTaskExecuted == 1);
 }
+
+/**
+ * Test that tasks can accumulate into per-worker slots indexed by the
+ * worker index without any synchronization.
+ */
+TEST_CASE("ThreadPool_PerWorkerArray_IndexedByWorker", "[ThreadPool]")
+{
+    auto& myPool = ThreadPool<Tags::DefaultPool>::InstanceGet();
+    REQUIRE(myPool.WorkerIndexGet() == WorkerContext::npos);
+
+    PBB::CacheAlignedArray<int> counts(myPool.NThreadsGet(), 0);
+    const int nTasks = 100;
+
+    std::vector<TaskFuture<void>> futures;
+    for (int i = 0; i < nTasks; i++)
+    {
+        futures.emplace_back(myPool.Submit(
+          [&]() noexcept -> void { counts[myPool.WorkerIndexGet()]++; }, nullptr));
+    }
+    for (auto& future : futures)
+    {
+        future.Get();
+    }
+
+    int total = 0;
+    for (int count : counts)
+    {
+        total += count;
+    }
+    REQUIRE(total == nTasks);
+}
+
+/**
+ * Test that tasks can allocate from the per-worker arena and that the
+ * high-water mark is reported.
+ */
+TEST_CASE("ThreadPool_WorkerArena_HighWaterMarkReported", "[ThreadPool]")
+{
+    auto& myPool = ThreadPool<Tags::DefaultPool>::InstanceGet();
+    REQUIRE(WorkerContext::CurrentMemoryResource() == std::pmr::get_default_resource());
+
+    const std::size_t nValues = 10000;
+    auto future = myPool.Submit(
+      [nValues]() noexcept -> bool
+      {
+          std::pmr::memory_resource* pResource = WorkerContext::CurrentMemoryResource();
+          std::pmr::vector<int> values(pResource);
+          values.reserve(nValues);
+          for (std::size_t i = 0; i < nValues; i++)
+          {
+              values.push_back(static_cast<int>(i));
+          }
+          return pResource != std::pmr::get_default_resource() && values.back() == 9999;
+      },
+      nullptr);
+    REQUIRE(future.Get());
+
+    const auto highWaterMarks = myPool.ArenaHighWaterMarks();
+    REQUIRE(highWaterMarks.size() == myPool.NThreadsGet());
+    REQUIRE(*std::max_element(highWaterMarks.begin(), highWaterMarks.end()) >=
+      nValues * sizeof(int));
+}
+
+namespace
+{
+// Records the priority of every task, in the order the tasks start
+class PriorityRecorder
+{
+  public:
+    auto Task(TaskPriority priority)
+    {
+        return [this, priority]() noexcept -> void
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_order.push_back(priority);
+        };
+    }
+
+    const std::vector<TaskPriority>& OrderGet() const { return m_order; }
+
+  private:
+    std::mutex m_mutex;
+    std::vector<TaskPriority> m_order;
+};
+} // namespace
+
+/**
+ * Test that queued tasks are executed in the order of their priority.
+ * Workers dequeue tasks in order, but a task may record itself after a
+ * task dequeued later, while up to nThreads - 1 other workers run, so
+ * each task may be recorded after at most nThreads - 1 tasks of a lower
+ * priority. With a single worker, the order is exact.
+ */
+TEST_CASE("ThreadPool_Priority_HighBeforeBackground", "[ThreadPool]")
+{
+    auto& myPool = ThreadPool<Tags::DefaultPool>::InstanceGet();
+    const std::size_t nThreads = myPool.NThreadsGet();
+    // Fewer than the aging limit, such that lower priorities are not promoted
+    constexpr std::size_t nEach = 8;
+
+    // Occupy all workers, such that subsequent tasks are queued
+    WorkerBlocker blocker(myPool);
+
+    PriorityRecorder recorder;
+    std::vector<TaskFuture<void>> futures;
+    for (TaskPriority priority :
+      { TaskPriority::Background, TaskPriority::Normal, TaskPriority::High })
+    {
+        for (std::size_t i = 0; i < nEach; i++)
+        {
+            futures.push_back(myPool.Submit(priority, recorder.Task(priority), nullptr));
+        }
+    }
+    blocker.Release();
+    for (auto& future : futures)
+    {
+        future.Get();
+    }
+
+    const std::vector<TaskPriority>& order = recorder.OrderGet();
+    REQUIRE(order.size() == futures.size());
+    REQUIRE(order.front() == TaskPriority::High);
+    for (TaskPriority priority :
+      { TaskPriority::High, TaskPriority::Normal, TaskPriority::Background })
+    {
+        REQUIRE(static_cast<std::size_t>(std::count(order.begin(), order.end(), priority)) ==
+          nEach);
+    }
+    for (std::size_t i = 0; i < order.size(); i++)
+    {
+        // Tasks of a lower priority recorded before this one
+        const auto overtaken = static_cast<std::size_t>(std::count_if(order.begin(),
+          order.begin() + static_cast<std::ptrdiff_t>(i),
+          [&](TaskPriority earlier) { return earlier > order[i]; }));
+        REQUIRE(overtaken <= nThreads - 1);
+    }
+}
+
+/**
+ * Test that a background task is not starved by a stream of
+ * high-priority tasks, but served within the aging limit.
+ */
+TEST_CASE("ThreadPool_Priority_AgingServesBackground", "[ThreadPool]")
+{
+    auto& myPool = ThreadPool<Tags::DefaultPool>::InstanceGet();
+    const std::size_t nThreads = myPool.NThreadsGet();
+    constexpr std::size_t agingLimit = PBB::MRMWQueue<int>::DefaultAgingLimit;
+
+    WorkerBlocker blocker(myPool);
+
+    PriorityRecorder recorder;
+    std::vector<TaskFuture<void>> futures;
+    futures.push_back(myPool.Submit(
+      TaskPriority::Background, recorder.Task(TaskPriority::Background), nullptr));
+    for (std::size_t i = 0; i < 3 * agingLimit; i++)
+    {
+        futures.push_back(
+          myPool.Submit(TaskPriority::High, recorder.Task(TaskPriority::High), nullptr));
+    }
+    blocker.Release();
+    for (auto& future : futures)
+    {
+        future.Get();
+    }
+
+    const std::vector<TaskPriority>& order = recorder.OrderGet();
+    REQUIRE(order.size() == futures.size());
+    const auto position = static_cast<std::size_t>(
+      std::find(order.begin(), order.end(), TaskPriority::Background) - order.begin());
+    // Popped after being bypassed agingLimit times, while the other workers may
+    // record up to nThreads - 1 tasks popped before it later
+    REQUIRE(position <= agingLimit + nThreads - 1);
+}
+
+/**
+ * Test that tasks submitted to a full queue are rejected with an error
+ * future or executed by the caller, depending on the policy.
+ */
+TEST_CASE("ThreadPool_BoundedQueue_RejectionPolicies", "[ThreadPool]")
+{
+    auto& myPool = ThreadPool<Tags::DefaultPool>::InstanceGet();
+    const std::size_t capacity = 2;
+
+    SECTION("Reject")
+    {
+        WorkerBlocker blocker(myPool);
+        myPool.QueueCapacitySet(capacity, RejectionPolicy::Reject);
+        std::vector<TaskFuture<int>> futures;
+        for (int i = 0; i < 4; i++)
+        {
+            futures.push_back(myPool.Submit([i]() noexcept { return i; }, nullptr));
+        }
+        blocker.Release();
+        REQUIRE(futures[0].Get() == 0);
+        REQUIRE(futures[1].Get() == 1);
+        REQUIRE_THROWS_AS(futures[2].Get(), QueueFullError);
+        REQUIRE_THROWS_AS(futures[3].Get(), QueueFullError);
+    }
+
+#ifndef PBB_USE_SHARDED_QUEUE
+    SECTION("RejectConcurrentProducers")
+    {
+        // Producers racing for the last room never overshoot the
+        // capacity. Sharded queues divide it over the shards.
+        WorkerBlocker blocker(myPool);
+        myPool.QueueCapacitySet(capacity, RejectionPolicy::Reject);
+        constexpr std::size_t nProducers = 4;
+        std::vector<std::vector<TaskFuture<int>>> futures(nProducers);
+        std::vector<std::thread> producers;
+        for (std::size_t i = 0; i < nProducers; i++)
+        {
+            producers.emplace_back(
+              [&myPool, &submitted = futures[i]]()
+              {
+                  for (int j = 0; j < 16; j++)
+                  {
+                      submitted.push_back(myPool.Submit([j]() noexcept { return j; }, nullptr));
+                  }
+              });
+        }
+        for (auto& producer : producers)
+        {
+            producer.join();
+        }
+        blocker.Release();
+        std::size_t accepted = 0;
+        for (auto& submitted : futures)
+        {
+            for (auto& future : submitted)
+            {
+                try
+                {
+                    future.Get();
+                    accepted++;
+                }
+                catch (const QueueFullError&)
+                {
+                }
+            }
+        }
+        REQUIRE(accepted == capacity);
+    }
+#endif
+
+    SECTION("CallerRuns")
+    {
+        WorkerBlocker blocker(myPool);
+        myPool.QueueCapacitySet(capacity, RejectionPolicy::CallerRuns);
+        std::vector<TaskFuture<std::thread::id>> futures;
+        for (int i = 0; i < 3; i++)
+        {
+            futures.push_back(myPool.Submit(
+              []() noexcept { return std::this_thread::get_id(); }, nullptr));
+        }
+        // Executed inline, since the queue is full
+        REQUIRE(futures[2].Get() == std::this_thread::get_id());
+        blocker.Release();
+        REQUIRE(futures[0].Get() != std::this_thread::get_id());
+    }
+
+    SECTION("BlockWithTimeout")
+    {
+        WorkerBlocker blocker(myPool);
+        myPool.QueueCapacitySet(capacity, RejectionPolicy::Block, std::chrono::milliseconds(20));
+        std::vector<TaskFuture<int>> futures;
+        for (int i = 0; i < 3; i++)
+        {
+            futures.push_back(myPool.Submit([i]() noexcept { return i; }, nullptr));
+        }
+        blocker.Release();
+        REQUIRE(futures[1].Get() == 1);
+        REQUIRE_THROWS_AS(futures[2].Get(), QueueFullError);
+    }
+
+    myPool.QueueCapacitySet(0);
+}
+
+TEST_CASE("ThreadPool_Stats_CountsTasksAndRejections", "[ThreadPool]")
+{
+    auto& myPool = ThreadPool<Tags::DefaultPool>::InstanceGet();
+    ThreadPoolStats before;
+    {
+        WorkerBlocker blocker(myPool);
+        // Every worker counted its previous task, e.g. of an earlier test,
+        // before taking a blocking one
+        before = myPool.Stats();
+        myPool.QueueCapacitySet(1, RejectionPolicy::Reject);
+        auto queued = myPool.Submit([]() noexcept { return 0; }, nullptr);
+        auto rejected = myPool.Submit([]() noexcept { return 1; }, nullptr);
+        REQUIRE(myPool.Stats().queue.depth == 1);
+        blocker.Release();
+        REQUIRE(queued.Get() == 0);
+        REQUIRE_THROWS_AS(rejected.Get(), QueueFullError);
+    }
+    myPool.QueueCapacitySet(0);
+    REQUIRE(myPool.Stats().tasksRejected == before.tasksRejected + 1);
+
+    if constexpr (PBB::StatsEnabled)
+    {
+        // Workers count a task after its future is ready
+        const std::uint64_t expected = before.tasksExecuted + myPool.NThreadsGet() + 1;
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (myPool.Stats().tasksExecuted < expected &&
+          std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::yield();
+        }
+        const ThreadPoolStats after = myPool.Stats();
+        REQUIRE(after.tasksExecuted == expected);
+        REQUIRE(after.queue.peakDepth >= 1);
+#ifndef PBB_USE_TBB_QUEUE
+        REQUIRE(after.queue.pushes >= before.queue.pushes + 1);
+#endif
+    }
+}
+
+/**
+ * Test that the default and the custom worker loop record tasks, busy,
+ * idle and CPU time per worker.
+ */
+TEST_CASE("ThreadPool_WorkerStats_BusyIdleAndCpuTime", "[ThreadPool]")
+{
+    using namespace std::chrono_literals;
+    auto check = [](auto& pool)
+    {
+        const auto before = pool.WorkerStats();
+        REQUIRE(before.size() == pool.NThreadsGet());
+
+        // Spin, such that the task consumes CPU time
+        auto future = pool.Submit(
+          []() noexcept
+          {
+              const auto end = std::chrono::steady_clock::now() + 20ms;
+              while (std::chrono::steady_clock::now() < end)
+              {
+              }
+              return 1;
+          },
+          nullptr);
+        REQUIRE(future.Get() == 1);
+        if constexpr (!PBB::StatsEnabled)
+        {
+            REQUIRE(pool.Utilization() == 0.0);
+            return;
+        }
+
+        // Workers count a task after its future is ready
+        std::uint64_t tasks = 0;
+        std::chrono::nanoseconds busy{ 0 };
+        std::chrono::nanoseconds idle{ 0 };
+        std::chrono::nanoseconds cpu{ 0 };
+        const auto deadline = std::chrono::steady_clock::now() + 5s;
+        while (tasks == 0 && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(1ms);
+            const auto after = pool.WorkerStats();
+            tasks = 0;
+            busy = idle = cpu = std::chrono::nanoseconds::zero();
+            for (std::size_t i = 0; i < after.size(); i++)
+            {
+                tasks += after[i].tasksExecuted - before[i].tasksExecuted;
+                busy += after[i].busyTime - before[i].busyTime;
+                idle += after[i].idleTime - before[i].idleTime;
+                cpu += after[i].cpuTime - before[i].cpuTime;
+            }
+        }
+        REQUIRE(tasks >= 1);
+        REQUIRE(busy >= 20ms);
+        REQUIRE(idle > 0ns);
+#ifdef __linux__
+        REQUIRE(cpu >= 5ms);
+#endif
+        const double utilization = pool.Utilization();
+        REQUIRE(utilization > 0.0);
+        REQUIRE(utilization <= 100.0);
+    };
+
+    SECTION("DefaultPool")
+    {
+        check(ThreadPool<Tags::DefaultPool>::InstanceGet());
+    }
+    SECTION("CustomPool")
+    {
+        check(ThreadPool<Tags::CustomPool>::InstanceGet());
+    }
+}
+
+/**
+ * Test that queue delay and run time percentiles are reported for the
+ * pool and per init key.
+ */
+TEST_CASE("ThreadPool_Latency_PercentilesPerPoolAndKey", "[ThreadPool]")
+{
+    using namespace std::chrono_literals;
+    auto& myPool = ThreadPool<Tags::DefaultPool>::InstanceGet();
+    myPool.LatencyByKeySet(true);
+    int key = 0;
+
+    std::vector<TaskFuture<void>> futures;
+    for (int i = 0; i < 20; i++)
+    {
+        futures.push_back(myPool.Submit(
+          []() noexcept -> void { std::this_thread::sleep_for(2ms); }, &key));
+    }
+    for (auto& future : futures)
+    {
+        future.Get();
+    }
+    // Workers record a task after its future is ready
+    const auto deadline = std::chrono::steady_clock::now() + 5s;
+    while (PBB::StatsEnabled && myPool.Latency(&key).runTime.count < 20 &&
+      std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(1ms);
+    }
+    myPool.LatencyByKeySet(false);
+
+    const PBB::LatencyStats total = myPool.Latency();
+    const PBB::LatencyStats keyed = myPool.Latency(&key);
+    if constexpr (PBB::StatsEnabled)
+    {
+        REQUIRE(keyed.runTime.count == 20);
+        REQUIRE(keyed.queueDelay.count == 20);
+        REQUIRE(total.runTime.count >= 20);
+        REQUIRE(keyed.runTime.p50 >= 1ms);
+        REQUIRE(keyed.runTime.p99 >= keyed.runTime.p50);
+        REQUIRE(keyed.runTime.p999 >= keyed.runTime.p99);
+        // Tasks queue behind each other on few workers
+        REQUIRE(keyed.queueDelay.p99 > 0ns);
+    }
+    else
+    {
+        REQUIRE(total.runTime.count == 0);
+        REQUIRE(keyed.runTime.count == 0);
+    }
+}
+
+TEST_CASE("ThreadPool_Watchdog_ReportsLongTaskAndDumpsState", "[ThreadPool]")
+{
+    using namespace std::chrono_literals;
+    auto& myPool = ThreadPool<Tags::DefaultPool>::InstanceGet();
+    int key = 0;
+
+    std::mutex mutex;
+    std::vector<StallReport> reports;
+    myPool.WatchdogStart(40ms,
+      [&](const StallReport& report)
+      {
+          std::lock_guard<std::mutex> guard(mutex);
+          reports.push_back(report);
+      });
+
+    std::atomic<bool> started{ false };
+    auto future = myPool.Submit(
+      [&started]() noexcept -> void
+      {
+          started = true;
+          std::this_thread::sleep_for(200ms);
+      },
+      &key);
+    while (!started)
+    {
+        std::this_thread::yield();
+    }
+    const PoolState state = myPool.StateGet();
+    REQUIRE(state.workers.size() == myPool.NThreadsGet());
+    REQUIRE(std::any_of(state.workers.begin(), state.workers.end(),
+      [&key](const WorkerActivity& worker)
+      { return worker.state == WorkerState::Running && worker.key == &key; }));
+    std::ostringstream dump;
+    myPool.DumpState(dump);
+    REQUIRE(dump.str().find("running") != std::string::npos);
+
+    future.Get();
+    myPool.WatchdogStop();
+
+    std::lock_guard<std::mutex> guard(mutex);
+    REQUIRE(reports.size() == 1);
+    REQUIRE(reports.front().kind == StallKind::Task);
+    REQUIRE(reports.front().key == &key);
+    REQUIRE(reports.front().worker < myPool.NThreadsGet());
+    REQUIRE(reports.front().duration >= 40ms);
+}
+
+#ifndef PBB_HEADER_ONLY
+/**
+ * Test that shutting down drains the queue, and that the pool can be
+ * re-created afterwards.
+ */
+TEST_CASE("ThreadPool_Shutdown_DrainCompletesQueuedTasks", "[ThreadPool]")
+{
+    using Pool = ThreadPool<Tags::DefaultPool>;
+    auto& myPool = Pool::InstanceGet();
+    std::vector<TaskFuture<int>> futures;
+    for (int i = 0; i < 8; i++)
+    {
+        futures.push_back(myPool.Submit(
+          [i]() noexcept
+          {
+              std::this_thread::sleep_for(std::chrono::milliseconds(1));
+              return i;
+          },
+          nullptr));
+    }
+    REQUIRE(myPool.Shutdown(ShutdownMode::Drain));
+    for (int i = 0; i < 8; i++)
+    {
+        REQUIRE(futures[static_cast<std::size_t>(i)].Get() == i);
+    }
+
+    // Tasks submitted after shutdown are cancelled
+    auto late = myPool.Submit([]() noexcept { return 0; }, nullptr);
+    REQUIRE_THROWS_AS(late.Get(), TaskCancelledError);
+
+    Pool::InstanceDestroy();
+    REQUIRE(Pool::InstanceGet().Submit([]() noexcept { return 1; }, nullptr).Get() == 1);
+}
+
+/**
+ * Test that queued tasks are cancelled, either immediately or when
+ * draining times out, and that their futures do not block.
+ */
+TEST_CASE("ThreadPool_Shutdown_CancelsQueuedTasks", "[ThreadPool]")
+{
+    using Pool = ThreadPool<Tags::DefaultPool>;
+    const auto mode = GENERATE(ShutdownMode::Cancel, ShutdownMode::Drain);
+    auto& myPool = Pool::InstanceGet();
+
+    auto blocker = std::make_unique<WorkerBlocker>(myPool);
+    std::vector<TaskFuture<int>> futures;
+    for (int i = 0; i < 4; i++)
+    {
+        futures.push_back(myPool.Submit([i]() noexcept { return i; }, nullptr));
+    }
+
+    // Running tasks always complete, release them while shutting down
+    std::thread releaser(
+      [&]
+      {
+          std::this_thread::sleep_for(std::chrono::milliseconds(50));
+          blocker->Release();
+      });
+    const auto start = std::chrono::steady_clock::now();
+    REQUIRE_FALSE(myPool.Shutdown(mode, std::chrono::milliseconds(10)));
+    releaser.join();
+    REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+
+    for (auto& future : futures)
+    {
+        REQUIRE_THROWS_AS(future.Get(), TaskCancelledError);
+    }
+    blocker.reset();
+    Pool::InstanceDestroy();
+}
+#endif
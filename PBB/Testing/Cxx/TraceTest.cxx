@@ -0,0 +1,143 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <PBB/ThreadPool.hpp>
+#include <PBB/Trace.hpp>
+
+using namespace PBB::Thread;
+
+TEST_CASE("Trace_Region_ExportedWithThreadName", "[Trace]")
+{
+    PBB::Trace::Start();
+    std::thread recorder(
+      []
+      {
+          PBB::Trace::ThreadNameSet("Recorder \"A\"");
+          PBB::Trace::Region region("Frame");
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      });
+    recorder.join();
+    PBB::Trace::Stop();
+    REQUIRE(!PBB::Trace::Enabled());
+
+    // Regions after stopping are not recorded
+    {
+        PBB::Trace::Region region("Ignored");
+    }
+
+    std::ostringstream os;
+    PBB::Trace::WriteChromeJson(os);
+    const std::string json = os.str();
+    REQUIRE(json.find("\"traceEvents\":[") != std::string::npos);
+    REQUIRE(json.find("Ignored") == std::string::npos);
+    if constexpr (PBB::Trace::Compiled)
+    {
+        REQUIRE(json.find("\"name\":\"Frame\"") != std::string::npos);
+        REQUIRE(json.find("\"ph\":\"X\"") != std::string::npos);
+        REQUIRE(json.find("\"name\":\"Recorder \\\"A\\\"\"") != std::string::npos);
+    }
+    else
+    {
+        REQUIRE(json.find("Frame") == std::string::npos);
+    }
+}
+
+TEST_CASE("Trace_ThreadPool_TasksAndQueueWaits", "[Trace]")
+{
+    auto& myPool = ThreadPool<Tags::DefaultPool>::InstanceGet();
+    int key = 0;
+
+    PBB::Trace::Start();
+    std::vector<TaskFuture<void>> futures;
+    for (int i = 0; i < 10; i++)
+    {
+        futures.push_back(myPool.Submit(
+          []() noexcept -> void { std::this_thread::sleep_for(std::chrono::milliseconds(1)); },
+          &key));
+    }
+    for (auto& future : futures)
+    {
+        future.Get();
+    }
+    // Workers record a task after its future is ready
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    PBB::Trace::Stop();
+
+    std::ostringstream os;
+    PBB::Trace::WriteChromeJson(os);
+    const std::string json = os.str();
+    if constexpr (PBB::Trace::Compiled)
+    {
+        REQUIRE(json.find("\"name\":\"PBB worker 0\"") != std::string::npos);
+        REQUIRE(json.find("\"name\":\"Task\"") != std::string::npos);
+        REQUIRE(json.find("\"args\":{\"key\":" +
+                  std::to_string(reinterpret_cast<std::uintptr_t>(&key)) + "}") !=
+          std::string::npos);
+        REQUIRE(json.find("\"ph\":\"b\"") != std::string::npos);
+        REQUIRE(json.find("\"ph\":\"e\"") != std::string::npos);
+    }
+    else
+    {
+        REQUIRE(json.find("Task") == std::string::npos);
+    }
+}
+
+TEST_CASE("Trace_ThreadNameSet_RingSizedByStart", "[Trace]")
+{
+    // Named before tracing starts, like the workers of a pool
+    std::atomic<bool> named{ false };
+    std::atomic<bool> started{ false };
+    std::thread recorder(
+      [&]
+      {
+          PBB::Trace::ThreadNameSet("Bounded recorder");
+          named.store(true);
+          while (!started.load())
+          {
+              std::this_thread::yield();
+          }
+          for (int i = 0; i < 20; i++)
+          {
+              PBB::Trace::Region region("Bounded");
+          }
+      });
+    while (!named.load())
+    {
+        std::this_thread::yield();
+    }
+    PBB::Trace::Start(4);
+    started.store(true);
+    recorder.join();
+    PBB::Trace::Stop();
+
+    std::ostringstream os;
+    PBB::Trace::WriteChromeJson(os);
+    const std::string json = os.str();
+    std::size_t nRegions = 0;
+    for (auto pos = json.find("\"name\":\"Bounded\""); pos != std::string::npos;
+         pos = json.find("\"name\":\"Bounded\"", pos + 1))
+    {
+        nRegions++;
+    }
+    if constexpr (PBB::Trace::Compiled)
+    {
+        // The ring is created by the first event, using the capacity of Start()
+        REQUIRE(nRegions == 4);
+        REQUIRE(json.find("\"name\":\"Bounded recorder\"") != std::string::npos);
+    }
+    else
+    {
+        REQUIRE(nRegions == 0);
+    }
+
+    // Restore the default capacity for threads recording later
+    PBB::Trace::Start();
+    PBB::Trace::Stop();
+}
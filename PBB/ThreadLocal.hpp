@@ -16,13 +16,23 @@
 
 #include <PBB/Config.h>
 #include <PBB/Memory.hpp>
+#include <PBB/Numa.hpp>
+#if __cplusplus >= 202002L
+#include <PBB/ProfiledMutex.hpp>
+#endif
 
 #include <atomic>
 #include <concepts>
+#include <cstddef>
+#include <functional>
+#include <iterator>
 #include <memory>
 #include <mutex>
+#include <new>
 #include <shared_mutex> // Used to minimize contention (C++17)
 #include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #ifdef PBB_USE_TBB_MAP
@@ -39,44 +49,200 @@ namespace detail::v17
 {
 //! ThreadLocal
 /*!  ThreadLocal types with dynamic storage.
+
+  Each thread's storage slot T (by default a CacheAlignedPlacement) is
+  allocated by the thread itself from memory local to its NUMA node.
+  With PBB_USE_NUMA, each slot is a separate numa_alloc_local mapping,
+  i.e. a ThreadLocal costs an mmap call and at least one page per
+  thread. Otherwise slots are cache-aligned heap allocations placed by
+  first touch.
+
+  Values are created lazily on first access by a thread, either
+  default-constructed or using a factory/exemplar given at
+  construction. After the parallel phase, values can be reduced using
+  Combine(), visited using CombineEach() or iterated using begin()/end().
  */
-template <typename T, typename U = UnderlyingTypeT<T>,
-  typename = std::enable_if_t<std::is_default_constructible_v<U>>>
+template <typename T, typename U = UnderlyingTypeT<T>>
 class ThreadLocal
 {
   private:
     using StorageSharedPtr = std::shared_ptr<U>;
+    using Factory = std::function<U()>;
+#if __cplusplus >= 202002L
+    using StorageMutex = SharedMutex<"ThreadLocal::_storagemutex">;
+    using RegistryMutex = Mutex<"ThreadLocal::_registry_mutex">;
+#else
+    using StorageMutex = std::shared_mutex;
+    using RegistryMutex = std::mutex;
+#endif
 #ifdef PBB_USE_TBB_MAP
     tbb::concurrent_unordered_map<std::thread::id, StorageSharedPtr>
       _storage; // Thread-local storage
 #else
     std::unordered_map<std::thread::id, StorageSharedPtr> _storage;
-    std::shared_mutex _storagemutex;
+    StorageMutex _storagemutex;
 #endif
 
-    std::vector<U*> _registry;          // Stores thread-local variable references
-    mutable std::mutex _registry_mutex; // Protects the registry
+    Factory _factory;                      // Creates initial values, empty for default construction
+    std::vector<U*> _registry;             // Stores thread-local variable references
+    mutable RegistryMutex _registry_mutex; // Protects the registry
 
     /**
-     * Register thread-local value, only once per thread
+     * Register thread-local value. Called exactly once per created value
      *
      */
     void RegisterThreadLocalValue(U* pValue)
     {
-        thread_local bool is_registered = false;
-        if (!is_registered)
+        std::lock_guard<RegistryMutex> lock(_registry_mutex);
+        _registry.push_back(pValue);
+    }
+
+    /**
+     * Create the storage slot T for the calling thread. The slot is
+     * allocated on the NUMA node of the calling thread (or relies on
+     * first-touch) and the returned pointer aliases the underlying value.
+     *
+     */
+    template <typename... Args>
+    static StorageSharedPtr CreateSlot(Args&&... args)
+    {
+        void* memory = Numa::AllocateLocal(sizeof(T), alignof(T));
+        T* pSlot = nullptr;
+        try
         {
-            { // Lock the registry separately
-                std::lock_guard<std::mutex> lock(_registry_mutex);
-                _registry.push_back(pValue);
+            if constexpr (std::is_aggregate_v<T>)
+            {
+                pSlot = new (memory) T{ std::forward<Args>(args)... };
+            }
+            else
+            {
+                pSlot = new (memory) T(std::forward<Args>(args)...);
             }
+        }
+        catch (...)
+        {
+            Numa::DeallocateLocal(memory, sizeof(T), alignof(T));
+            throw;
+        }
+        std::shared_ptr<T> slot(pSlot,
+          [](T* p)
+          {
+              p->~T();
+              Numa::DeallocateLocal(p, sizeof(T), alignof(T));
+          });
+        return StorageSharedPtr(std::move(slot), &UnderlyingValue(*pSlot));
+    }
 
-            is_registered = true;
+    /**
+     * Create an initial value using the factory or the default constructor
+     *
+     */
+    StorageSharedPtr CreateValue() const
+    {
+        if constexpr (std::is_default_constructible_v<U>)
+        {
+            if (!_factory)
+            {
+                return CreateSlot();
+            }
+        }
+        if constexpr (std::is_move_constructible_v<U>)
+        {
+            return CreateSlot(_factory());
+        }
+        else
+        {
+            // The factory and exemplar constructors require a movable U
+            return CreateSlot();
         }
     }
 
+    U InitialValue() const
+    {
+        if constexpr (std::is_default_constructible_v<U>)
+        {
+            if (!_factory)
+            {
+                return U{};
+            }
+        }
+        return _factory();
+    }
+
   public:
-    ThreadLocal() = default;
+    //! Iterator over the thread-local values (dereferences to U&)
+    class Iterator
+    {
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = U;
+        using difference_type = std::ptrdiff_t;
+        using pointer = U*;
+        using reference = U&;
+
+        Iterator() = default;
+        explicit Iterator(typename std::vector<U*>::const_iterator it)
+          : m_it(it)
+        {
+        }
+
+        reference operator*() const { return **m_it; }
+        pointer operator->() const { return *m_it; }
+        Iterator& operator++()
+        {
+            ++m_it;
+            return *this;
+        }
+        Iterator operator++(int)
+        {
+            Iterator tmp = *this;
+            ++m_it;
+            return tmp;
+        }
+        bool operator==(const Iterator& rhs) const { return m_it == rhs.m_it; }
+        bool operator!=(const Iterator& rhs) const { return m_it != rhs.m_it; }
+
+      private:
+        typename std::vector<U*>::const_iterator m_it;
+    };
+
+    /**
+     * Default constructor. Values are default-constructed
+     */
+    template <typename V = U, typename = std::enable_if_t<std::is_default_constructible_v<V>>>
+    ThreadLocal()
+    {
+    }
+
+    /**
+     * Construct using a factory. Each thread-local value is
+     * initialized with the result of invoking factory(), which must be
+     * thread-safe.
+     *
+     * @param factory - callable returning U, which must be movable
+     */
+    template <typename F,
+      typename = std::enable_if_t<std::is_invocable_r_v<U, F&> && !std::is_same_v<U, F> &&
+        std::is_move_constructible_v<U>>>
+    explicit ThreadLocal(F factory)
+      : _factory(std::move(factory))
+    {
+    }
+
+    /**
+     * Construct using an exemplar. Each thread-local value is a copy
+     * of exemplar.
+     *
+     * @param exemplar - initial value, which must be movable
+     */
+    template <typename V = U, typename = std::enable_if_t<std::is_move_constructible_v<V>>>
+    explicit ThreadLocal(const U& exemplar)
+      : _factory([exemplar]() { return exemplar; })
+    {
+    }
+
+    ThreadLocal(const ThreadLocal&) = delete;
+    ThreadLocal& operator=(const ThreadLocal&) = delete;
 
     /**
      * Access thread-local value
@@ -99,14 +265,18 @@ class ThreadLocal
               typename tbb::concurrent_unordered_map<std::thread::id, StorageSharedPtr>::iterator,
               bool>
               result;
-            result = _storage.emplace(thread_id, std::make_shared<U>());
+            result = _storage.emplace(thread_id, CreateValue());
 
             it = result.first;
+            if (result.second)
+            {
+                RegisterThreadLocalValue(it->second.get());
+            }
         }
         pValue = it->second.get();
 #else
         {
-            std::shared_lock<std::shared_mutex> read_lock(_storagemutex);
+            std::shared_lock<StorageMutex> read_lock(_storagemutex);
             auto it = _storage.find(thread_id);
             if (it != _storage.end() && it->second)
             {
@@ -117,23 +287,91 @@ class ThreadLocal
         if (!pValue)
         {
             // If not found, take an exclusive lock and insert
-            std::unique_lock<std::shared_mutex> write_lock(_storagemutex);
+            std::unique_lock<StorageMutex> write_lock(_storagemutex);
             auto& value_ptr = _storage[thread_id];
 
             // Double-check to avoid race conditions
             if (!value_ptr)
             {
-                value_ptr = std::make_shared<U>();
+                value_ptr = CreateValue();
+                RegisterThreadLocalValue(value_ptr.get());
             }
             pValue = value_ptr.get();
         }
 #endif
-
-        // Auto-registration
-        RegisterThreadLocalValue(pValue);
         return *pValue;
     }
 
+    /**
+     * Reduce all thread-local values using a binary operation. If no
+     * thread has accessed its value, the initial value is returned.
+     *
+     * @param op - binary operation U(const U&, const U&)
+     * @return Combined value
+     */
+    template <typename BinaryOp>
+    U Combine(BinaryOp op) const
+    {
+        std::lock_guard<RegistryMutex> lock(_registry_mutex);
+        if (_registry.empty())
+        {
+            return InitialValue();
+        }
+        auto it = _registry.begin();
+        U result = **it;
+        for (++it; it != _registry.end(); ++it)
+        {
+            result = op(result, **it);
+        }
+        return result;
+    }
+
+    /**
+     * Invoke a unary function on every thread-local value
+     *
+     * @param fn - callable accepting U&
+     */
+    template <typename UnaryOp>
+    void CombineEach(UnaryOp fn)
+    {
+        std::lock_guard<RegistryMutex> lock(_registry_mutex);
+        for (U* pValue : _registry)
+        {
+            fn(*pValue);
+        }
+    }
+
+    /**
+     * Reset all thread-local values to their initial value. The
+     * per-thread allocations are kept, so references obtained through
+     * Local() remain valid.
+     */
+    void Clear()
+    {
+        std::lock_guard<RegistryMutex> lock(_registry_mutex);
+        for (U* pValue : _registry)
+        {
+            *pValue = InitialValue();
+        }
+    }
+
+    /**
+     * Number of threads, which have accessed their value
+     */
+    std::size_t Size() const
+    {
+        std::lock_guard<RegistryMutex> lock(_registry_mutex);
+        return _registry.size();
+    }
+
+    /**
+     * Lock-free iteration over the thread-local values. Only valid
+     * once the parallel phase is over, i.e. when no thread can call
+     * Local() concurrently.
+     */
+    Iterator begin() const { return Iterator(_registry.cbegin()); }
+    Iterator end() const { return Iterator(_registry.cend()); }
+
     /**
      * Access registry (should only be done by a single thread)
      *
@@ -145,9 +383,20 @@ class ThreadLocal
         return _registry;
     }
 
+    /**
+     * Access for locking the registry from outside. The type is stable,
+     * with PBB_PROFILE_LOCKS, it is the mutex wrapped by the profiled
+     * registry mutex, and locks taken through it are not profiled.
+     *
+     * @return Reference to registry mutex
+     */
     std::mutex& GetMutex() const
     {
+#if __cplusplus >= 202002L
+        return NativeMutex(_registry_mutex);
+#else
         return _registry_mutex;
+#endif
     }
 };
 } // namespace detail::v17
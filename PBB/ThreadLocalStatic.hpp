@@ -16,6 +16,9 @@
 
 #include <PBB/Config.h>
 #include <PBB/Memory.hpp>
+#if __cplusplus >= 202002L
+#include <PBB/ProfiledMutex.hpp>
+#endif
 
 #include <atomic>
 #include <concepts>
@@ -46,16 +49,23 @@ class ThreadLocal
 {
   private:
     using StorageSharedPtr = std::shared_ptr<U>;
+#if __cplusplus >= 202002L
+    using StorageMutex = SharedMutex<"ThreadLocalStatic::_storagemutex">;
+    using RegistryMutex = Mutex<"ThreadLocalStatic::_registry_mutex">;
+#else
+    using StorageMutex = std::shared_mutex;
+    using RegistryMutex = std::mutex;
+#endif
 #ifdef PBB_USE_TBB_MAP
     tbb::concurrent_unordered_map<std::thread::id, StorageSharedPtr>
       _storage; // Thread-local storage
 #else
     std::unordered_map<std::thread::id, StorageSharedPtr> _storage;
-    std::shared_mutex _storagemutex;
+    StorageMutex _storagemutex;
 #endif
 
-    std::vector<U*> _registry;          // Stores thread-local variable references
-    mutable std::mutex _registry_mutex; // Protects the registry
+    std::vector<U*> _registry;             // Stores thread-local variable references
+    mutable RegistryMutex _registry_mutex; // Protects the registry
 
     /**
      * Register thread-local value, only once per thread
@@ -67,7 +77,7 @@ class ThreadLocal
         if (!is_registered)
         {
             { // Lock the registry separately
-                std::lock_guard<std::mutex> lock(_registry_mutex);
+                std::lock_guard<RegistryMutex> lock(_registry_mutex);
                 _registry.push_back(pValue);
             }
 
@@ -106,7 +116,7 @@ class ThreadLocal
         pValue = it->second.get();
 #else
         {
-            std::shared_lock<std::shared_mutex> read_lock(_storagemutex);
+            std::shared_lock<StorageMutex> read_lock(_storagemutex);
             auto it = _storage.find(thread_id);
             if (it != _storage.end() && it->second)
             {
@@ -117,7 +127,7 @@ class ThreadLocal
         if (!pValue)
         {
             // If not found, take an exclusive lock and insert
-            std::unique_lock<std::shared_mutex> write_lock(_storagemutex);
+            std::unique_lock<StorageMutex> write_lock(_storagemutex);
             auto& value_ptr = _storage[thread_id];
 
             // Double-check to avoid race conditions
@@ -145,9 +155,19 @@ class ThreadLocal
         return _registry;
     }
 
+    /**
+     * Access for locking the registry from outside. With
+     * PBB_PROFILE_LOCKS, locks taken through it are not profiled.
+     *
+     * @return Reference to registry mutex
+     */
     std::mutex& GetMutex() const
     {
+#if __cplusplus >= 202002L
+        return NativeMutex(_registry_mutex);
+#else
         return _registry_mutex;
+#endif
     }
 };
 } // namespace detail::v17
@@ -174,11 +194,11 @@ class ThreadLocal
 #else
     std::unordered_map<std::thread::id, StorageSharedPtr> _storage;
     // We need a mutex since std::unordered_map is not thread-safe
-    std::mutex _storage_mutex;
+    Mutex<"ThreadLocalStatic::_storage_mutex"> _storage_mutex;
 #endif
 
-    std::vector<U*> _registry;          // Stores thread-local variable references
-    mutable std::mutex _registry_mutex; // Protects the registry
+    std::vector<U*> _registry; // Stores thread-local variable references
+    mutable Mutex<"ThreadLocalStatic::_registry_mutex"> _registry_mutex; // Protects the registry
 
     /**
      * Register thread-local value, only once per thread. TODO: Remove this
@@ -191,7 +211,7 @@ class ThreadLocal
         {
             {
                 // Lock the registry separately (not thread-safe by design)
-                std::lock_guard<std::mutex> lock(_registry_mutex);
+                std::lock_guard lock(_registry_mutex);
                 _registry.push_back(pValue);
             }
             is_registered = true;
@@ -215,7 +235,7 @@ class ThreadLocal
 
         { // Scoped lock to protect storage_ from race conditions
 #ifndef PBB_USE_TBB_MAP
-            std::lock_guard<std::mutex> lock(
+            std::lock_guard lock(
               _storage_mutex); // Can be skipped if we use tbb::concurrent_unordered_map
 #endif
             // For std::unordered_map, we could operate without atomics (we are behind a lock)
@@ -256,13 +276,14 @@ class ThreadLocal
     }
 
     /**
-     * Access for locking registry from outside
+     * Access for locking registry from outside. With PBB_PROFILE_LOCKS,
+     * locks taken through it are not profiled.
      *
      * @return Reference to registry mutex
      */
     std::mutex& GetMutex() const
     {
-        return _registry_mutex;
+        return NativeMutex(_registry_mutex);
     }
 };
 } // namespace detail::v20
@@ -70,9 +70,28 @@ class PBB_EXPORT ThreadPool
     template <typename Func, typename... Args>
     requires std::invocable<Func, Args...>
     auto Submit(Func&& func, Args&&... args, void* key)
+    {
+        return ThreadPoolTraits<Tag>::Submit(*this, TaskPriority::Normal,
+          std::forward<Func>(func), std::forward<Args>(args)..., key);
+    }
+
+    /**
+     * @brief Submit
+     *
+     * Submit with a priority. Tasks of higher priority are executed
+     * before queued tasks of lower priority.
+     *
+     * @param priority - priority of the task
+     * @param func - functor
+     * @param args - any number of arguments
+     * @return future
+     */
+    template <typename Func, typename... Args>
+    requires std::invocable<Func, Args...>
+    auto Submit(TaskPriority priority, Func&& func, Args&&... args, void* key)
     {
         return ThreadPoolTraits<Tag>::Submit(
-          *this, std::forward<Func>(func), std::forward<Args>(args)..., key);
+          *this, priority, std::forward<Func>(func), std::forward<Args>(args)..., key);
     }
 
     /**
@@ -87,6 +106,9 @@ class PBB_EXPORT ThreadPool
     template <typename Func, typename... Args>
     auto SubmitDefault(Func&& func, Args&&... args, void* key);
 
+    template <typename Func, typename... Args>
+    auto SubmitDefault(TaskPriority priority, Func&& func, Args&&... args, void* key);
+
   protected:
     ThreadPool() = default;
     ~ThreadPool() override;
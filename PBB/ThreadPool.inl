@@ -14,6 +14,15 @@ auto ThreadPool<Tag>::SubmitDefault(Func&& func, Args&&... args, void* key)
       std::forward<Func>(func), std::forward<Args>(args)..., key);
 }
 
+template <typename Tag>
+template <typename Func, typename... Args>
+auto ThreadPool<Tag>::SubmitDefault(
+  TaskPriority priority, Func&& func, Args&&... args, void* key)
+{
+    return this->ThreadPoolBase<Tag, ThreadPool<Tag>>::DefaultSubmit(
+      std::forward<Func>(func), std::forward<Args>(args)..., key, priority);
+}
+
 #if 0
 template <typename Tag, typename Derived>
 template <typename Func, typename... Args>
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstdlib>
+#include <new>
+
 #include <PBB/ThreadPool.hpp>
 #include <PBB/ThreadPoolBase.hpp>
 
@@ -9,16 +12,50 @@ namespace PBB::Thread
 /**
  * Destryoy
  *
- * Invalidates the queue and joins all running threads.
+ * Cancels queued tasks and joins all running threads.
  */
 template <typename Tag, typename Derived>
 void ThreadPoolBase<Tag, Derived>::Destroy()
 {
-    this->m_done.test_and_set(std::memory_order_release);
+    this->Shutdown(ShutdownMode::Cancel, std::chrono::milliseconds::zero());
+}
+
+template <typename Tag, typename Derived>
+bool ThreadPoolBase<Tag, Derived>::Shutdown(ShutdownMode mode, std::chrono::milliseconds timeout)
+{
+    std::lock_guard<std::mutex> lock(this->m_shutdownMutex);
 
+    // Reject new tasks, workers exit once the queue is drained
 #ifdef PBB_USE_TBB_QUEUE
+    this->m_workQueue.close();
     {
-        std::lock_guard lock(m_mutex);
+        std::lock_guard guard(m_mutex);
+        m_condition.notify_all();
+    }
+#else
+    this->m_workQueue.Close();
+#endif
+
+    if (mode == ShutdownMode::Drain)
+    {
+        std::unique_lock<std::mutex> exitLock(this->m_exitMutex);
+        auto exited = [this]() { return this->m_runningWorkers == 0; };
+        if (timeout == std::chrono::milliseconds::max())
+        {
+            this->m_exitCondition.wait(exitLock, exited);
+        }
+        else
+        {
+            this->m_exitCondition.wait_for(exitLock, timeout, exited);
+        }
+    }
+
+    // Cancel what is left and stop the workers after their current task
+    this->CancelQueued();
+    this->m_done.test_and_set(std::memory_order_release);
+#ifdef PBB_USE_TBB_QUEUE
+    {
+        std::lock_guard guard(m_mutex);
         m_condition.notify_all();
     }
 #else
@@ -32,19 +69,66 @@ void ThreadPoolBase<Tag, Derived>::Destroy()
             thread.join();
         }
     }
+
+    // Tasks pushed concurrently with closing the queue
+    this->CancelQueued();
+    return !this->m_cancelled;
+}
+
+template <typename Tag, typename Derived>
+void ThreadPoolBase<Tag, Derived>::CancelQueued() noexcept
+{
+    TaskPayload payload{ nullptr, nullptr };
+#ifdef PBB_USE_TBB_QUEUE
+    while (this->m_workQueue.try_pop(payload))
+#else
+    while (this->m_workQueue.TryPop(payload))
+#endif
+    {
+        if (payload.first)
+        {
+            payload.first->Cancel(
+              std::make_exception_ptr(TaskCancelledError("Task cancelled by pool shutdown")));
+            payload.first.reset();
+            this->m_cancelled = true;
+        }
+    }
+}
+
+/**
+ * Constructor using @ref DefaultNThreads threads
+ */
+template <typename Tag, typename Derived>
+ThreadPoolBase<Tag, Derived>::ThreadPoolBase()
+  : ThreadPoolBase(DefaultNThreads())
+{
 }
 
 /**
- * Constructor
+ * Number of threads of a default constructed pool. A positive integer
+ * in the environment variable PBB_NUM_THREADS takes precedence, e.g.
+ * for scaling runs or sharing a host.
  *
  * Always create at least one thread. If hardware_concurrency() returns 0,
  * subtracting one would turn it to UINT_MAX, so get the maximum of
  * hardware_concurrency() and 2 before subtracting 1.
  */
 template <typename Tag, typename Derived>
-ThreadPoolBase<Tag, Derived>::ThreadPoolBase()
-  : ThreadPoolBase(std::max(2u, std::thread::hardware_concurrency()) - 1u)
+std::size_t ThreadPoolBase<Tag, Derived>::DefaultNThreads()
 {
+#ifdef _MSC_VER
+#pragma warning(suppress : 4996)
+#endif
+    if (const char* pValue = std::getenv("PBB_NUM_THREADS"))
+    {
+        char* pEnd = nullptr;
+        const unsigned long value = std::strtoul(pValue, &pEnd, 10);
+        if (pEnd != pValue && *pEnd == '\0' && value > 0)
+        {
+            return static_cast<std::size_t>(value);
+        }
+    }
+    return std::max(2u, std::thread::hardware_concurrency()) - 1u;
 }
 
 /**
@@ -54,15 +138,36 @@ template <typename Tag, typename Derived>
 ThreadPoolBase<Tag, Derived>::ThreadPoolBase(std::size_t numThreads)
 {
     this->m_done.clear();
+    this->m_runningWorkers = numThreads;
+    for (std::size_t i = 0; i < numThreads; ++i)
+    {
+        this->m_workers.emplace_back(std::make_unique<WorkerContext>(this, i));
+    }
     for (std::size_t i = 0; i < numThreads; ++i)
     {
-        this->m_threads.emplace_back([this] { static_cast<ThreadPool<Tag>*>(this)->Worker(); });
+        this->m_threads.emplace_back(
+          [this, pContext = this->m_workers[i].get(), i]
+          {
+              Trace::ThreadNameSet("PBB worker " + std::to_string(i));
+              {
+                  WorkerContext::Scope scope(*pContext);
+                  pContext->ThreadStarted();
+                  static_cast<ThreadPool<Tag>*>(this)->Worker();
+                  pContext->ThreadStopped();
+              }
+              std::lock_guard<std::mutex> lock(this->m_exitMutex);
+              if (--this->m_runningWorkers == 0)
+              {
+                  this->m_exitCondition.notify_all();
+              }
+          });
     }
 }
 
 template <typename Tag, typename Derived>
 ThreadPoolBase<Tag, Derived>::~ThreadPoolBase()
 {
+    this->WatchdogStop();
     this->Destroy();
 }
 
@@ -72,4 +177,233 @@ size_t ThreadPoolBase<Tag, Derived>::NThreadsGet() const
     return this->m_threads.size();
 }
 
+template <typename Tag, typename Derived>
+std::vector<std::size_t> ThreadPoolBase<Tag, Derived>::ArenaHighWaterMarks() const
+{
+    std::vector<std::size_t> highWaterMarks;
+    highWaterMarks.reserve(this->m_workers.size());
+    for (const auto& pContext : this->m_workers)
+    {
+        highWaterMarks.push_back(pContext->ArenaHighWater());
+    }
+    return highWaterMarks;
+}
+
+template <typename Tag, typename Derived>
+std::vector<WorkerSnapshot> ThreadPoolBase<Tag, Derived>::WorkerStats() const
+{
+    std::vector<WorkerSnapshot> stats;
+    stats.reserve(this->m_workers.size());
+    for (const auto& pContext : this->m_workers)
+    {
+        stats.push_back(pContext->Stats());
+    }
+    return stats;
+}
+
+template <typename Tag, typename Derived>
+double ThreadPoolBase<Tag, Derived>::Utilization() const
+{
+    WorkerSnapshot total;
+    for (const auto& pContext : this->m_workers)
+    {
+        const WorkerSnapshot stats = pContext->Stats();
+        total.busyTime += stats.busyTime;
+        total.idleTime += stats.idleTime;
+    }
+    return total.Utilization();
+}
+
+template <typename Tag, typename Derived>
+LatencyStats ThreadPoolBase<Tag, Derived>::Latency() const
+{
+    auto pMerged = std::make_unique<TaskLatency>();
+    for (const auto& pContext : this->m_workers)
+    {
+        pContext->MergeLatency(*pMerged);
+    }
+    return { pMerged->queueDelay.Percentiles(), pMerged->runTime.Percentiles() };
+}
+
+template <typename Tag, typename Derived>
+LatencyStats ThreadPoolBase<Tag, Derived>::Latency(const void* key) const
+{
+    auto pMerged = std::make_unique<TaskLatency>();
+    for (const auto& pContext : this->m_workers)
+    {
+        pContext->MergeLatency(key, *pMerged);
+    }
+    return { pMerged->queueDelay.Percentiles(), pMerged->runTime.Percentiles() };
+}
+
+template <typename Tag, typename Derived>
+void ThreadPoolBase<Tag, Derived>::LatencyByKeySet(bool enable)
+{
+    for (const auto& pContext : this->m_workers)
+    {
+        pContext->LatencyByKeySet(enable);
+    }
+}
+
+template <typename Tag, typename Derived>
+PoolState ThreadPoolBase<Tag, Derived>::StateGet() const
+{
+    PoolState state;
+    state.workers.reserve(this->m_workers.size());
+    for (const auto& pContext : this->m_workers)
+    {
+        state.workers.push_back(pContext->Activity());
+    }
+    state.queueDepth = this->Stats().queue.depth;
+    return state;
+}
+
+template <typename Tag, typename Derived>
+void ThreadPoolBase<Tag, Derived>::DumpState(std::ostream& os) const
+{
+    WriteState(os, this->StateGet());
+}
+
+template <typename Tag, typename Derived>
+void ThreadPoolBase<Tag, Derived>::WatchdogStart(
+  std::chrono::milliseconds threshold, Watchdog::StallHandler onStall)
+{
+    std::lock_guard<std::mutex> guard(this->m_watchdogMutex);
+    this->m_watchdog.reset();
+    this->m_watchdog = std::make_unique<Watchdog>(
+      [this]() { return this->StateGet(); }, threshold, std::move(onStall));
+}
+
+template <typename Tag, typename Derived>
+void ThreadPoolBase<Tag, Derived>::WatchdogStop()
+{
+    std::lock_guard<std::mutex> guard(this->m_watchdogMutex);
+    this->m_watchdog.reset();
+}
+
+template <typename Tag, typename Derived>
+ThreadPoolStats ThreadPoolBase<Tag, Derived>::Stats() const
+{
+    ThreadPoolStats stats;
+    stats.queue = this->m_workQueue.Stats();
+    for (const auto& pContext : this->m_workers)
+    {
+        stats.tasksExecuted += pContext->TasksExecuted();
+    }
+    stats.tasksRejected = this->m_tasksRejected.load(std::memory_order_relaxed);
+    stats.tasksCallerRuns = this->m_tasksCallerRuns.load(std::memory_order_relaxed);
+    return stats;
+}
+
+template <typename Tag, typename Derived>
+void ThreadPoolBase<Tag, Derived>::QueueCapacitySet(
+  std::size_t capacity, RejectionPolicy policy, std::chrono::milliseconds timeout)
+{
+    this->m_rejectionPolicy.store(policy);
+    this->m_blockTimeout.store(timeout.count());
+#ifdef PBB_USE_TBB_QUEUE
+    this->m_workQueue.set_capacity(capacity);
+#else
+    this->m_workQueue.CapacitySet(capacity);
+#endif
+}
+
+template <typename Tag, typename Derived>
+void ThreadPoolBase<Tag, Derived>::Enqueue(TaskPayload&& payload, std::size_t lane) noexcept
+{
+#if defined(PBB_ENABLE_STATS)
+    payload.first->SubmittedSet(Clock::Now());
+#elif defined(PBB_ENABLE_TRACE)
+    if (Trace::Enabled())
+    {
+        payload.first->SubmittedSet(Clock::Now());
+    }
+#endif
+    PBB_PROBE3(task_submit, payload.first.get(), payload.second, lane);
+    const RejectionPolicy policy = this->m_rejectionPolicy.load(std::memory_order_relaxed);
+    const std::chrono::milliseconds timeout{ this->m_blockTimeout.load(
+      std::memory_order_relaxed) };
+
+    bool queued = false;
+    try
+    {
+#ifdef PBB_USE_TBB_QUEUE
+        queued = this->m_workQueue.try_push(std::move(payload), lane);
+        if (!queued && !this->m_workQueue.closed() && policy == RejectionPolicy::Block)
+        {
+            // TBB offers no blocking push, poll for room
+            const auto start = std::chrono::steady_clock::now();
+            while (!queued && !this->m_done.test(std::memory_order_acquire) &&
+              std::chrono::steady_clock::now() - start < timeout)
+            {
+                std::this_thread::yield();
+                queued = this->m_workQueue.try_push(std::move(payload), lane);
+            }
+        }
+#else
+        queued = this->m_workQueue.TryPush(std::move(payload), lane);
+        if (!queued && !this->m_workQueue.Closed() && policy == RejectionPolicy::Block)
+        {
+            queued = timeout == std::chrono::milliseconds::max()
+              ? this->m_workQueue.Push(std::move(payload), lane)
+              : this->m_workQueue.TryPushFor(std::move(payload), timeout, lane);
+        }
+#endif
+    }
+    catch (const std::bad_alloc&)
+    {
+        // The queue could not grow, the task is left untouched and rejected
+        PBB_PROBE3(task_rejected, payload.first.get(), payload.second, static_cast<int>(policy));
+        this->m_tasksRejected.fetch_add(1, std::memory_order_relaxed);
+        payload.first->Cancel(
+          std::make_exception_ptr(QueueFullError("Work queue cannot allocate memory")));
+        return;
+    }
+
+#ifdef PBB_USE_TBB_QUEUE
+    if (queued)
+    {
+        std::lock_guard lock(this->m_mutex);
+        this->m_condition.notify_one();
+        return;
+    }
+    const bool closed = this->m_workQueue.closed();
+#else
+    if (queued)
+    {
+        return;
+    }
+    const bool closed = this->m_workQueue.Closed();
+#endif
+
+    PBB_PROBE3(task_rejected, payload.first.get(), payload.second, static_cast<int>(policy));
+    if (closed)
+    {
+        payload.first->Cancel(
+          std::make_exception_ptr(TaskCancelledError("Thread pool is shut down")));
+    }
+    else if (policy == RejectionPolicy::CallerRuns &&
+      ThreadPoolTraits<Tag>::CanRunInline(this->Self(), payload.second))
+    {
+        this->m_tasksCallerRuns.fetch_add(1, std::memory_order_relaxed);
+        payload.first->Execute();
+    }
+    else
+    {
+        this->m_tasksRejected.fetch_add(1, std::memory_order_relaxed);
+        payload.first->Cancel(std::make_exception_ptr(QueueFullError("Work queue is full")));
+    }
+}
+
+template <typename Tag, typename Derived>
+size_t ThreadPoolBase<Tag, Derived>::WorkerIndexGet() const noexcept
+{
+    const WorkerContext* pContext = WorkerContext::Current();
+    if (pContext && pContext->Owner() == this)
+    {
+        return pContext->Index();
+    }
+    return WorkerContext::npos;
+}
+
 } // namespace PBB::Thread
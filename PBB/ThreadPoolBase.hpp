@@ -1,19 +1,29 @@
 #pragma once
 
 #include <atomic>
-#ifdef PBB_USE_TBB_QUEUE
+#include <chrono>
 #include <condition_variable>
-#include <functional>
+#include <memory>
 #include <mutex>
+#ifdef PBB_USE_TBB_QUEUE
+#include <functional>
 #endif
 #include <thread>
 #include <vector>
 
+#include <PBB/Probes.hpp>
+#include <PBB/ProfiledMutex.hpp>
+#include <PBB/QueueStats.hpp>
 #include <PBB/ThreadPoolCommon.hpp>
 #include <PBB/ThreadPoolTags.hpp>
+#include <PBB/Watchdog.hpp>
+#include <PBB/WorkerContext.hpp>
 
 #ifdef PBB_USE_TBB_QUEUE
+#include <array>
 #include <tbb/concurrent_queue.h>
+#elif defined(PBB_USE_SHARDED_QUEUE)
+#include <PBB/ShardedMRMWQueue.hpp>
 #else
 #include <PBB/MRMWQueue.hpp>
 #endif
@@ -30,6 +40,122 @@ struct ThreadPoolTraits;
 namespace PBB::Thread
 {
 
+#ifdef PBB_USE_TBB_QUEUE
+//! TBBLaneQueue
+/*!
+  One TBB queue per priority. Every AgingInterval'th pop serves the
+  lanes in reverse order, such that lower priorities make progress.
+ */
+template <typename T, std::size_t Lanes>
+class TBBLaneQueue
+{
+  public:
+    static constexpr std::size_t AgingInterval = 32;
+
+    void push(T&& item, std::size_t lane)
+    {
+        m_counters.RaisePeak(m_size.fetch_add(1, std::memory_order_relaxed) + 1);
+        m_lanes[lane].push(std::move(item));
+    }
+
+    // Room is reserved by incrementing the size, such that concurrent
+    // pushes never overshoot the capacity
+    bool try_push(T&& item, std::size_t lane)
+    {
+        if (closed())
+            return false;
+        const std::size_t capacity = m_capacity.load(std::memory_order_relaxed);
+        std::size_t size = m_size.load(std::memory_order_relaxed);
+        do
+        {
+            if (capacity != 0 && size >= capacity)
+                return false;
+        } while (!m_size.compare_exchange_weak(size, size + 1, std::memory_order_relaxed));
+        m_counters.RaisePeak(size + 1);
+        try
+        {
+            m_lanes[lane].push(std::move(item));
+        }
+        catch (...)
+        {
+            m_size.fetch_sub(1, std::memory_order_relaxed);
+            throw;
+        }
+        return true;
+    }
+
+    bool try_pop(T& item)
+    {
+        if (m_pops.fetch_add(1, std::memory_order_relaxed) % AgingInterval == AgingInterval - 1)
+        {
+            for (std::size_t lane = Lanes; lane-- > 0;)
+            {
+                if (m_lanes[lane].try_pop(item))
+                {
+                    m_size.fetch_sub(1, std::memory_order_relaxed);
+                    return true;
+                }
+            }
+            return false;
+        }
+        for (auto& lane : m_lanes)
+        {
+            if (lane.try_pop(item))
+            {
+                m_size.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void set_capacity(std::size_t capacity) { m_capacity.store(capacity); }
+
+    void close() { m_closed.store(true, std::memory_order_release); }
+    bool closed() const { return m_closed.load(std::memory_order_acquire); }
+
+    bool empty() const
+    {
+        for (const auto& lane : m_lanes)
+        {
+            if (!lane.empty())
+                return false;
+        }
+        return true;
+    }
+
+    // Only the approximate depth and peak depth are known
+    QueueStats Stats() const noexcept
+    {
+        QueueStats stats;
+        stats.depth = m_size.load(std::memory_order_relaxed);
+        m_counters.Collect(stats);
+        return stats;
+    }
+
+  private:
+    std::array<tbb::concurrent_queue<T>, Lanes> m_lanes;
+    std::atomic<std::size_t> m_pops{ 0 };
+    std::atomic<std::size_t> m_size{ 0 };
+    std::atomic<std::size_t> m_capacity{ 0 };
+    std::atomic<bool> m_closed{ false };
+    [[no_unique_address]] PBB::detail::v20::QueueCounters m_counters;
+};
+#endif
+
+//! ThreadPoolStats
+/*!
+  Snapshot of the pool telemetry. Rejections are always counted, the
+  remaining counters require PBB_ENABLE_STATS.
+ */
+struct ThreadPoolStats
+{
+    QueueStats queue;                   ///< Work queue, only depths with the TBB queue
+    std::uint64_t tasksExecuted{ 0 };   ///< Tasks completed by the workers
+    std::uint64_t tasksRejected{ 0 };   ///< Tasks cancelled, since the queue was full
+    std::uint64_t tasksCallerRuns{ 0 }; ///< Tasks run by the submitter, since the queue was full
+};
+
 template <typename Tag, typename Derived>
 class ThreadPoolBase
 {
@@ -44,19 +170,32 @@ class ThreadPoolBase
 
     size_t NThreadsGet() const;
 
+    /**
+     * Index of the calling worker thread in [0, NThreadsGet()). Use it
+     * for indexing per-worker data, e.g. a @ref CacheAlignedArray
+     * sized using NThreadsGet().
+     *
+     * @return Index or WorkerContext::npos if not called from a worker of this pool
+     */
+    size_t WorkerIndexGet() const noexcept;
+
   protected:
-    using TaskPtr = std::unique_ptr<IThreadTask>;
+    using TaskPtr = PBB::Thread::TaskPtr;
     using TaskPayload = std::pair<TaskPtr, void*>;
 #ifdef PBB_USE_TBB_QUEUE
-    using QueueImpl = tbb::concurrent_queue<TaskPayload>;
+    using QueueImpl = TBBLaneQueue<TaskPayload, TaskPriorityCount>;
+#elif defined(PBB_USE_SHARDED_QUEUE)
+    using QueueImpl = PBB::ShardedMRMWQueue<TaskPayload, TaskPriorityCount>;
 #else
-    using QueueImpl = PBB::MRMWQueue<TaskPayload>;
+    using QueueImpl = PBB::MRMWQueue<TaskPayload, TaskPriorityCount>;
 #endif
 
     ThreadPoolBase();
 
     explicit ThreadPoolBase(std::size_t numThreads);
 
+    static std::size_t DefaultNThreads();
+
     ~ThreadPoolBase();
 
     void Worker()
@@ -65,18 +204,154 @@ class ThreadPoolBase
     }
 
     /**
-     * Invalidates the queue and joins all running threads.
+     * Cancels queued tasks and joins all running threads.
      */
     void Destroy();
 
+    /**
+     * Cancel all queued tasks, storing a TaskCancelledError in their futures
+     */
+    void CancelQueued() noexcept;
+
+  public:
+    /**
+     * Stop accepting tasks and join the workers. Tasks submitted after
+     * shutdown are cancelled. Tasks already running always complete.
+     *
+     * @param mode - drain or cancel the queued tasks
+     * @param timeout - maximum time to drain the queue, remaining
+     *                  tasks are cancelled afterwards
+     * @return True if no queued tasks were cancelled
+     */
+    bool Shutdown(ShutdownMode mode = ShutdownMode::Drain,
+      std::chrono::milliseconds timeout = std::chrono::milliseconds::max());
+
+    /**
+     * High-water marks of the per-worker arenas, i.e. the largest
+     * number of bytes allocated by a single task on each worker.
+     *
+     * @return One entry per worker
+     */
+    std::vector<std::size_t> ArenaHighWaterMarks() const;
+
+    /**
+     * Snapshot of the work queue and worker counters. Taking it does
+     * not stop the pool, so the counters are not mutually consistent.
+     */
+    ThreadPoolStats Stats() const;
+
+    /**
+     * Execution statistics of each worker: tasks completed, busy, idle
+     * and CPU time. Requires PBB_ENABLE_STATS, otherwise only the
+     * indices are filled in.
+     *
+     * @return One entry per worker
+     */
+    std::vector<WorkerSnapshot> WorkerStats() const;
+
+    /**
+     * Percentage of the time the workers have spent executing tasks,
+     * zero unless compiled with PBB_ENABLE_STATS
+     */
+    double Utilization() const;
+
+    /**
+     * Percentiles of the queue delay, from submission until a worker
+     * starts the task, and of the run time, merged over the workers.
+     * Requires PBB_ENABLE_STATS, otherwise no samples are recorded.
+     */
+    LatencyStats Latency() const;
+
+    /**
+     * Latency percentiles of the tasks submitted with a given init key.
+     * Only recorded while enabled using LatencyByKeySet().
+     */
+    LatencyStats Latency(const void* key) const;
+
+    /**
+     * Record latency per init key. Costs an uncontended lock and a
+     * lookup per task.
+     */
+    void LatencyByKeySet(bool enable);
+
+    /**
+     * Activity of every worker, i.e. whether it is idle, running or
+     * initializing and for which init key, and the queue depth. Cheap
+     * enough to sample periodically.
+     */
+    PoolState StateGet() const;
+
+    /**
+     * Write the state of every worker, e.g. when the pool appears stuck
+     */
+    void DumpState(std::ostream& os) const;
+
+    /**
+     * Start a watchdog thread reporting tasks and init functions
+     * running longer than a threshold, and queued tasks not started by
+     * any worker. Replaces a running watchdog.
+     *
+     * @param threshold - duration after which a stall is reported
+     * @param onStall - called on the watchdog thread, by default the
+     *                  report and the state are written to std::cerr
+     */
+    void WatchdogStart(
+      std::chrono::milliseconds threshold, Watchdog::StallHandler onStall = nullptr);
+
+    void WatchdogStop();
+
+    /**
+     * Bound the number of queued tasks to apply backpressure on
+     * producers. Tasks submitted to a full queue are handled according
+     * to the rejection policy. Rejected tasks are not executed and
+     * their futures throw a @ref QueueFullError. The caller never
+     * executes a per-thread initialization function, so using
+     * RejectionPolicy::CallerRuns, tasks with a key having one are
+     * rejected.
+     *
+     * @param capacity - maximum number of queued tasks, zero for unbounded
+     * @param policy - action when the queue is full
+     * @param timeout - maximum time to wait for room using RejectionPolicy::Block
+     */
+    void QueueCapacitySet(std::size_t capacity, RejectionPolicy policy = RejectionPolicy::Block,
+      std::chrono::milliseconds timeout = std::chrono::milliseconds::max());
+
+  protected:
+    /**
+     * Queue a task or handle it according to the rejection policy. A
+     * task is also rejected if the queue cannot allocate memory for it.
+     */
+    void Enqueue(TaskPayload&& payload, std::size_t lane) noexcept;
+
+    std::atomic<RejectionPolicy> m_rejectionPolicy{ RejectionPolicy::Block };
+    std::atomic<std::chrono::milliseconds::rep> m_blockTimeout{
+        std::chrono::milliseconds::max().count()
+    };
+
+    // Counted off the hot path, when the queue is full
+    std::atomic<std::uint64_t> m_tasksRejected{ 0 };
+    std::atomic<std::uint64_t> m_tasksCallerRuns{ 0 };
+
     std::atomic_flag m_done = ATOMIC_FLAG_INIT;
     QueueImpl m_workQueue;
+    std::vector<std::unique_ptr<WorkerContext>> m_workers;
     std::vector<std::thread> m_threads;
 
+    // Shutdown, waiting for workers to exit after draining the queue
+    std::mutex m_shutdownMutex;
+    std::mutex m_exitMutex;
+    std::condition_variable m_exitCondition;
+    std::size_t m_runningWorkers{ 0 };
+    bool m_cancelled{ false }; // Queued tasks have been cancelled by a shutdown
+
+    // Stopped first thing in the destructor, before the workers are destroyed
+    std::mutex m_watchdogMutex;
+    std::unique_ptr<Watchdog> m_watchdog;
+
 #ifdef PBB_USE_TBB_QUEUE
     // Intel TBB queue is thread-safe and non-blocking, we need synchronization
-    std::mutex m_mutex;
-    std::condition_variable m_condition;
+    Mutex<"ThreadPool::m_mutex"> m_mutex;
+    ConditionVariable m_condition;
 #endif
 
     /**
@@ -88,6 +363,7 @@ class ThreadPoolBase
   public:
     void DefaultWorkerLoop()
     {
+        WorkerContext* pContext = WorkerContext::Current();
         while (!m_done.test(std::memory_order_acquire))
         {
             TaskPayload pTask{ nullptr, nullptr };
@@ -102,7 +378,11 @@ class ThreadPoolBase
                 //
                 // Note: condition_variable::wait can return spuriously,
                 m_condition.wait(lock,
-                  [&] { return m_done.test(std::memory_order_acquire) || !m_workQueue.empty(); });
+                  [&]
+                  {
+                      return m_done.test(std::memory_order_acquire) || !m_workQueue.empty() ||
+                        m_workQueue.closed();
+                  });
 
                 // Important: we must re-check m_done after waking up
                 // because:
@@ -115,16 +395,23 @@ class ThreadPoolBase
                 // At this point we assume there's work available.
                 // Try to get a task from the queue — it's possible another
                 // thread beat us to it, so this may still fail.
-                if (!m_workQueue.try_pop(pTask) || !pTask.first)
+                if (!m_workQueue.try_pop(pTask))
+                {
+                    // Closed and drained
+                    if (m_workQueue.closed())
+                        break;
+                    continue;
+                }
+                if (!pTask.first)
                     continue;
             }
 #else
-            // The MRMWQueue handles its own wait logic
+            // The MRMWQueue (or ShardedMRMWQueue) handles its own wait logic
             if (!m_workQueue.Pop(pTask))
             {
-                if (m_done.test(std::memory_order_acquire))
+                if (m_done.test(std::memory_order_acquire) || m_workQueue.Closed())
                 {
-                    // We are done
+                    // We are done, or the queue is closed and drained
                     break;
                 }
                 else
@@ -139,13 +426,22 @@ class ThreadPoolBase
                 continue;
             }
 #endif
+            PBB_PROBE3(task_dequeue, pTask.first.get(), pTask.second, pContext->Index());
+            pContext->BeginTask(pTask.first->SubmittedGet(), pTask.second);
+            PBB_PROBE3(task_start, pTask.first.get(), pTask.second, pContext->Index());
             pTask.first->Execute();
+            PBB_PROBE3(task_end, pTask.first.get(), pTask.second, pContext->Index());
+
+            // Release the task before reclaiming its task-scoped memory
+            pTask.first.reset();
+            pContext->EndTask();
         }
     }
 
     template <typename Func, typename... Args>
     requires noexcept_invocable<Func, Args...>
-    auto DefaultSubmit(Func&& func, Args&&... args, void* key = nullptr) noexcept;
+    auto DefaultSubmit(Func&& func, Args&&... args, void* key = nullptr,
+      TaskPriority priority = TaskPriority::Normal) noexcept;
 };
 
 } // namespace PBB::Thread
@@ -4,7 +4,8 @@ namespace PBB::Thread
 template <typename Tag, typename Derived>
 template <typename Func, typename... Args>
 requires noexcept_invocable<Func, Args...>
-auto ThreadPoolBase<Tag, Derived>::DefaultSubmit(Func&& func, Args&&... args, void* key) noexcept
+auto ThreadPoolBase<Tag, Derived>::DefaultSubmit(
+  Func&& func, Args&&... args, void* key, TaskPriority priority) noexcept
 {
     static_assert(
       std::invocable<Func, Args...>, "Submitted task must be invocable with given args");
@@ -12,8 +13,7 @@ auto ThreadPoolBase<Tag, Derived>::DefaultSubmit(Func&& func, Args&&... args, vo
     static_assert(noexcept(std::invoke(std::declval<Func>(), std::declval<Args>()...)),
       "Submitted task must be noexcept");
     using ResultType = std::invoke_result_t<Func, Args...>;
-    using PackagedTask = std::packaged_task<ResultType()>;
-    using TaskType = ThreadTask<PackagedTask>;
+    using Promise = std::promise<ResultType>;
 
     // Lambda are faster than using std::bind (but code more ugly)
     auto boundLambda = [f = std::forward<Func>(func),
@@ -29,18 +29,15 @@ auto ThreadPoolBase<Tag, Derived>::DefaultSubmit(Func&& func, Args&&... args, vo
         }
     };
 
-    PackagedTask task{ std::move(boundLambda) };
-    TaskFuture<ResultType> result{ task.get_future() };
+    using TaskType = PromiseTask<decltype(boundLambda), ResultType>;
 
-#ifdef PBB_USE_TBB_QUEUE
-    m_workQueue.push({ std::make_unique<TaskType>(std::move(task)), key });
-    {
-        std::lock_guard lock(m_mutex);
-        m_condition.notify_one();
-    }
-#else
-    m_workQueue.Push({ std::make_unique<TaskType>(std::move(task)), key });
-#endif
+    // Both the task and the shared state of the promise are taken from
+    // the task memory of the submitting thread
+    Promise promise(std::allocator_arg, TaskAllocator<ResultType>{});
+    TaskFuture<ResultType> result{ promise.get_future() };
+    TaskPtr task = MakeTask<TaskType>(std::move(boundLambda), std::move(promise));
+
+    Enqueue({ std::move(task), key }, static_cast<std::size_t>(priority));
     return result;
 }
 }
@@ -1,13 +1,16 @@
 #pragma once
 
 #include <any>
+#include <cstdint>
 #include <functional>
 #include <future>
 #include <memory>
+#include <stdexcept>
 #include <utility>
 
 #include <PBB/Common.hpp>
 #include <PBB/Config.h>
+#include <PBB/TaskAllocator.hpp>
 #include <PBB/pbb_export.h>
 
 namespace PBB::Thread
@@ -47,14 +50,55 @@ class PBB_EXPORT IThreadTask
         PBB_UNREFERENCED_PARAMETER(eptr);
     }
 
+    /**
+     * Called instead of Execute, when the task is not executed, e.g.
+     * rejected by a full queue. Tasks with a future should store the
+     * exception in it.
+     */
+    virtual void Cancel(std::exception_ptr eptr) noexcept { PBB_UNREFERENCED_PARAMETER(eptr); }
+
+    /**
+     * Time of submission in @ref Clock ticks, zero unless stamped by a
+     * pool compiled with PBB_ENABLE_STATS or tracing
+     */
+    std::uint64_t SubmittedGet() const noexcept { return m_submitted; }
+    void SubmittedSet(std::uint64_t ticks) noexcept { m_submitted = ticks; }
+
   protected:
     IThreadTask() = default;
 
   private:
     IThreadTask(const IThreadTask&) = delete;
     IThreadTask& operator=(const IThreadTask&) = delete;
+
+    std::uint64_t m_submitted{ 0 };
+};
+
+//! TaskDeleter
+/*!
+  Destroys a task and returns its memory to @ref TaskMemory
+ */
+struct TaskDeleter
+{
+    void operator()(IThreadTask* pTask) const noexcept
+    {
+        void* pMemory = dynamic_cast<void*>(pTask);
+        pTask->~IThreadTask();
+        TaskMemory::Deallocate(pMemory);
+    }
 };
 
+using TaskPtr = std::unique_ptr<IThreadTask, TaskDeleter>;
+
+/**
+ * Construct a task using @ref TaskMemory
+ *
+ * @param args - arguments for the constructor of TaskType
+ * @return Owning pointer to the task
+ */
+template <typename TaskType, typename... Args>
+TaskPtr MakeTask(Args&&... args);
+
 template <typename Func>
 requires std::is_move_constructible_v<Func>
 class ThreadTask : public IThreadTask
@@ -67,6 +111,79 @@ class ThreadTask : public IThreadTask
     Func m_func;
 };
 
+//! PromiseTask
+/*!
+  Task setting the result of a noexcept functor on a promise. Unlike
+  std::packaged_task, the shared state of the promise can be allocated
+  using a custom allocator.
+ */
+template <typename Func, typename Result>
+class PromiseTask : public IThreadTask
+{
+  public:
+    PromiseTask(Func&& func, std::promise<Result>&& promise);
+    void Execute() final;
+    void OnInitializeFailure(std::exception_ptr eptr) noexcept override;
+    void Cancel(std::exception_ptr eptr) noexcept override;
+
+  private:
+    Func m_func;
+    std::promise<Result> m_promise;
+};
+
+/**
+ * Priority of a submitted task. Workers serve higher priorities first,
+ * while aging ensures that lower priorities keep making progress.
+ */
+enum class TaskPriority : std::size_t
+{
+    High = 0,
+    Normal,
+    Background
+};
+
+constexpr std::size_t TaskPriorityCount = 3;
+
+/**
+ * Action taken when a task is submitted to a full queue
+ */
+enum class RejectionPolicy
+{
+    Block,      ///< Wait for room, until an optional timeout, then reject
+    CallerRuns, ///< Execute the task on the submitting thread. Tasks of a key with a
+                ///< per-thread initialization function are rejected instead.
+    Reject      ///< Fail immediately with a QueueFullError stored in the future
+};
+
+//! QueueFullError
+/*!
+  Stored in the future of a task rejected by a full queue
+ */
+class QueueFullError : public std::runtime_error
+{
+  public:
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * Handling of queued tasks when shutting down a pool
+ */
+enum class ShutdownMode
+{
+    Drain, ///< Execute queued tasks, cancelling those left at the timeout
+    Cancel ///< Cancel queued tasks, only tasks already running complete
+};
+
+//! TaskCancelledError
+/*!
+  Stored in the future of a task cancelled by a pool shutdown
+ */
+class TaskCancelledError : public std::runtime_error
+{
+  public:
+    using std::runtime_error::runtime_error;
+};
+
 enum class FuturePolicy
 {
     Wait,
@@ -100,6 +217,7 @@ class InitAwareTask : public ThreadTask<Func>
 
     explicit InitAwareTask(Func&& func, std::shared_ptr<Promise> promise);
     void OnInitializeFailure(std::exception_ptr eptr) noexcept override;
+    void Cancel(std::exception_ptr eptr) noexcept override;
 
   private:
     std::shared_ptr<Promise> m_promise;
@@ -8,6 +8,23 @@
 namespace PBB::Thread
 {
 
+// MakeTask implementation
+
+template <typename TaskType, typename... Args>
+TaskPtr MakeTask(Args&&... args)
+{
+    void* pMemory = TaskMemory::Allocate(sizeof(TaskType), alignof(TaskType));
+    try
+    {
+        return TaskPtr(new (pMemory) TaskType(std::forward<Args>(args)...));
+    }
+    catch (...)
+    {
+        TaskMemory::Deallocate(pMemory);
+        throw;
+    }
+}
+
 // ThreadTask implementation
 
 template <typename Func>
@@ -23,6 +40,48 @@ void ThreadTask<Func>::Execute()
     m_func();
 }
 
+// PromiseTask implementation
+
+template <typename Func, typename Result>
+PromiseTask<Func, Result>::PromiseTask(Func&& func, std::promise<Result>&& promise)
+  : m_func(std::move(func))
+  , m_promise(std::move(promise))
+{
+}
+
+template <typename Func, typename Result>
+void PromiseTask<Func, Result>::Execute()
+{
+    if constexpr (std::is_void_v<Result>)
+    {
+        m_func();
+        m_promise.set_value();
+    }
+    else
+    {
+        m_promise.set_value(m_func());
+    }
+}
+
+template <typename Func, typename Result>
+void PromiseTask<Func, Result>::OnInitializeFailure(std::exception_ptr eptr) noexcept
+{
+    Cancel(std::move(eptr));
+}
+
+template <typename Func, typename Result>
+void PromiseTask<Func, Result>::Cancel(std::exception_ptr eptr) noexcept
+{
+    try
+    {
+        m_promise.set_exception(std::move(eptr));
+    }
+    catch (const std::future_error&)
+    {
+        // Promise already satisfied — ignore
+    }
+}
+
 // TaskFuture implementation
 
 template <typename T>
@@ -49,7 +108,8 @@ TaskFuture<T>::~TaskFuture()
 {
     if (m_future.valid() && m_policy == FuturePolicy::Wait)
     {
-        m_future.get();
+        // Wait without rethrowing, e.g. a TaskCancelledError
+        m_future.wait();
     }
 }
 
@@ -64,6 +124,12 @@ InitAwareTask<Func, Promise>::InitAwareTask(Func&& func, std::shared_ptr<Promise
 
 template <typename Func, typename Promise>
 void InitAwareTask<Func, Promise>::OnInitializeFailure(std::exception_ptr eptr) noexcept
+{
+    Cancel(std::move(eptr));
+}
+
+template <typename Func, typename Promise>
+void InitAwareTask<Func, Promise>::Cancel(std::exception_ptr eptr) noexcept
 {
     try
     {
@@ -3,12 +3,12 @@
 #include <any>
 #include <functional>
 #include <mutex>
-#include <shared_mutex>
 #include <type_traits>
 #include <unordered_map>
 #include <utility>
 
 #include <PBB/Config.h>
+#include <PBB/ProfiledMutex.hpp>
 #include <PBB/pbb_export.h>
 
 #ifdef PBB_HEADER_ONLY
@@ -54,8 +54,16 @@ class PBB_EXPORT ThreadPool<Tags::CustomPool>
     auto Submit(Func&& func, Args&&... args, void* key)
     {
         // To please Microsoft, who cannot resolve this
+        return ThreadPoolTraits<Tags::CustomPool>::Submit(Self(), TaskPriority::Normal,
+          std::forward<Func>(func), std::forward<Args>(args)..., key);
+    }
+
+    template <typename Func, typename... Args>
+    requires std::invocable<Func, Args...>
+    auto Submit(TaskPriority priority, Func&& func, Args&&... args, void* key)
+    {
         return ThreadPoolTraits<Tags::CustomPool>::Submit(
-          Self(), std::forward<Func>(func), std::forward<Args>(args)..., key);
+          Self(), priority, std::forward<Func>(func), std::forward<Args>(args)..., key);
     }
 
     template <typename Func, typename... Args>
@@ -117,7 +125,7 @@ class PBB_EXPORT ThreadPool<Tags::CustomPool>
         return *static_cast<const ThreadPool<Tags::CustomPool>*>(this);
     }
     std::unordered_map<void*, std::function<std::any()>> m_initTasks;
-    std::shared_mutex m_initTasksMutex;
+    SharedMutex<"ThreadPoolCustom::m_initTasksMutex"> m_initTasksMutex;
 };
 
 } // namespace PBB::Thread
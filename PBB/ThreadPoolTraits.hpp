@@ -11,8 +11,10 @@
 #include <utility>
 
 #include <PBB/Common.hpp>
+#include <PBB/Probes.hpp>
 #include <PBB/ThreadPoolBase.hpp>
 #include <PBB/ThreadPoolTags.hpp>
+#include <PBB/Trace.hpp>
 namespace PBB::Thread
 {
 
@@ -31,11 +33,19 @@ struct ThreadPoolTraits
     }
 
     template <typename Pool, typename Func, typename... Args>
-    static auto Submit(Pool& self, Func&& func, Args&&... args, void* key)
+    static auto Submit(
+      Pool& self, TaskPriority priority, Func&& func, Args&&... args, void* key)
     {
         // Just forward to DefaultSubmit, which requires noexcept.
-        return self.SubmitDefault(std::forward<Func>(func), std::forward<Args>(args)..., key);
+        return self.SubmitDefault(
+          priority, std::forward<Func>(func), std::forward<Args>(args)..., key);
     }
+
+    /**
+     * Whether a task submitted to a full queue may be executed on the
+     * submitting thread using RejectionPolicy::CallerRuns
+     */
+    static bool CanRunInline(auto& /*self*/, void* /*key*/) { return true; }
 };
 
 //! ThreadPoolTraits<CustomPool>
@@ -68,6 +78,7 @@ struct ThreadPoolTraits<Tags::CustomPool>
 #if defined(__clang__)
 #pragma clang diagnostic pop
 #endif
+        WorkerContext* pContext = WorkerContext::Current();
         while (!self.m_done.test(std::memory_order_acquire))
         {
             typename std::remove_reference_t<decltype(self)>::TaskPayload pTask{ nullptr, nullptr };
@@ -83,7 +94,7 @@ struct ThreadPoolTraits<Tags::CustomPool>
                 self.m_condition.wait(lock,
                   [&] {
                       return self.m_done.test(std::memory_order_acquire) ||
-                        !self.m_workQueue.empty();
+                        !self.m_workQueue.empty() || self.m_workQueue.closed();
                   });
 
                 // Important: we must re-check m_done after waking up
@@ -97,13 +108,20 @@ struct ThreadPoolTraits<Tags::CustomPool>
                 // At this point we assume there's work available.
                 // Try to get a task from the queue — it's possible another
                 // thread beat us to it, so this may still fail.
-                if (!self.m_workQueue.try_pop(pTask) || !pTask.first)
+                if (!self.m_workQueue.try_pop(pTask))
+                {
+                    // Closed and drained
+                    if (self.m_workQueue.closed())
+                        break;
+                    continue;
+                }
+                if (!pTask.first)
                     continue;
             }
 #else
             if (!self.m_workQueue.Pop(pTask))
             {
-                if (self.m_done.test(std::memory_order_acquire))
+                if (self.m_done.test(std::memory_order_acquire) || self.m_workQueue.Closed())
                 {
                     // Facilitate that we can destroy pool
                     break;
@@ -118,6 +136,8 @@ struct ThreadPoolTraits<Tags::CustomPool>
                 continue;
             }
 #endif
+            PBB_PROBE3(task_dequeue, pTask.first.get(), pTask.second, pContext->Index());
+            pContext->BeginTask(pTask.first->SubmittedGet(), pTask.second);
             if (init_key != pTask.second)
             {
                 // Reset an earlier initialization result
@@ -132,7 +152,7 @@ struct ThreadPoolTraits<Tags::CustomPool>
                 {
 #ifdef _MSC_VER
                     // Locate the initialization function
-                    std::shared_lock<std::shared_mutex> lock(self.m_initTasksMutex);
+                    std::shared_lock<decltype(self.m_initTasksMutex)> lock(self.m_initTasksMutex);
                     // Microsoft bug
                     typename decltype(self.m_initTasks)::const_iterator it{};
                     it = self.m_initTasks.find(pTask.second);
@@ -153,42 +173,72 @@ struct ThreadPoolTraits<Tags::CustomPool>
                 {
                     // Execute the initialization function and
                     // handle any exception thrown
+                    PBB_PROBE2(init_start, pTask.second, pContext->Index());
+                    pContext->BeginInitialize();
                     try
                     {
+                        Trace::Region region("Initialize");
                         initTask();
                         initialized = true;
+                        pContext->EndInitialize();
+                        PBB_PROBE3(init_end, pTask.second, pContext->Index(), 1);
                     }
                     catch (...)
                     {
+                        pContext->EndInitialize();
+                        PBB_PROBE3(init_end, pTask.second, pContext->Index(), 0);
                         if (pTask.first)
                         {
                             pTask.first->OnInitializeFailure(std::current_exception());
                         }
+                        pTask.first.reset();
+                        pContext->EndTask();
                         continue; // Skip Execute
                     }
                 }
             }
 
             // Always execute - unless initialization failed.
+            PBB_PROBE3(task_start, pTask.first.get(), pTask.second, pContext->Index());
             pTask.first->Execute();
+            PBB_PROBE3(task_end, pTask.first.get(), pTask.second, pContext->Index());
+
+            // Release the task before reclaiming its task-scoped memory
+            pTask.first.reset();
+            pContext->EndTask();
         }
     }
 
+    /**
+     * Tasks with a registered initialization function are never
+     * executed on the submitting thread, since it has not executed the
+     * function. They are rejected instead.
+     */
+    static bool CanRunInline(auto& self, void* key)
+    {
+        std::shared_lock lock(self.m_initTasksMutex);
+        return !self.m_initTasks.contains(key);
+    }
+
     /**
      * @brief Submit function supporting invocable throwing and a registered per-thread
      * initialization function
      *
-     * @param parameter description
-     * @return description
+     * @param priority - priority lane of the task
+     * @param func - functor
+     * @return future
      */
     template <typename Pool, typename Func, typename... Args>
-    static auto Submit(Pool& self, Func&& func, Args&&... args, void* key)
+    static auto Submit(
+      Pool& self, TaskPriority priority, Func&& func, Args&&... args, void* key)
     {
         using ResultType = std::invoke_result_t<Func, Args...>;
         using Promise = std::promise<ResultType>;
         using Future = TaskFuture<ResultType>;
 
-        auto promise = std::make_shared<Promise>();
+        // Shared state and control block are taken from the task memory
+        auto promise = std::allocate_shared<Promise>(
+          TaskAllocator<Promise>{}, std::allocator_arg, TaskAllocator<ResultType>{});
         auto future = Future{ promise->get_future() };
         auto weak_promise = std::weak_ptr<Promise>(promise);
 
@@ -217,17 +267,8 @@ struct ThreadPoolTraits<Tags::CustomPool>
         };
 
         using Task = InitAwareTask<decltype(wrapped), Promise>;
-        auto task = std::make_unique<Task>(std::move(wrapped), std::move(promise));
-        // auto task = std::make_unique<Task>(wrapped, promise);
-#ifdef PBB_USE_TBB_QUEUE
-        self.m_workQueue.push({ std::move(task), key });
-        {
-            std::lock_guard lock(self.m_mutex);
-            self.m_condition.notify_one();
-        }
-#else
-        self.m_workQueue.Push({ std::move(task), key });
-#endif
+        auto task = MakeTask<Task>(std::move(wrapped), std::move(promise));
+        self.Enqueue({ std::move(task), key }, static_cast<std::size_t>(priority));
 
         return future;
     }
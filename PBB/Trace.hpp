@@ -0,0 +1,382 @@
+/**
+ * @file   Trace.hpp
+ * @author Jens Munk Hansen <jens.munk.hansen@gmail.com>
+ * @date   Wed Oct 21 10:22:48 CEST 2026
+ *
+ * @brief  Timeline tracing of tasks and regions, exported as Chrome
+ *         Trace Event JSON (chrome://tracing, Perfetto)
+ *
+ * Copyright 2025 Jens Munk Hansen
+ *
+ */
+#pragma once
+
+#if __cplusplus < 202002L
+#error "This header requires at least C++20"
+#endif
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <PBB/Clock.hpp>
+#include <PBB/Common.hpp>
+#include <PBB/Config.h>
+#include <PBB/OverwriteRing.hpp>
+#include <PBB/ProfiledMutex.hpp>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <pthread.h>
+#endif
+
+namespace PBB::Trace
+{
+#ifdef PBB_ENABLE_TRACE
+inline constexpr bool Compiled = true;
+#else
+inline constexpr bool Compiled = false;
+#endif
+
+enum class EventType : std::uint8_t
+{
+    Complete,  ///< Region with a begin and an end on the recording thread
+    QueueWait, ///< Time a task spent queued, shown as an async span
+};
+
+//! Event
+/*!
+  Trace event. The name must outlive the trace, e.g. a string literal.
+ */
+struct Event
+{
+    Clock::Ticks begin;
+    Clock::Ticks end;
+    const char* name;
+    std::uint64_t argument; ///< Init key of a task, zero if none
+    EventType type;
+};
+
+namespace detail
+{
+//! ThreadTrace
+/*!
+  Events of a single thread. Only the owning thread writes, while the
+  ring can be read at any time.
+ */
+struct ThreadTrace
+{
+    ThreadTrace(std::size_t capacity, std::uint32_t id)
+      : events(capacity)
+      , tid(id)
+    {
+    }
+    PBB_DELETE_COPY_CTORS(ThreadTrace);
+
+    OverwriteRing<Event> events;
+    const std::uint32_t tid;
+    std::string name; ///< Guarded by the registry mutex
+};
+
+//! TraceRegistry
+/*!
+  Traces of all threads, which have recorded an event. A thread's
+  trace is kept after it exits, such that its events can be exported.
+ */
+class TraceRegistry
+{
+  public:
+    static constexpr std::size_t DefaultCapacity = std::size_t{ 1 } << 14;
+
+    static TraceRegistry& InstanceGet()
+    {
+        // Intentionally leaked, threads may record during static destruction
+        static TraceRegistry* pInstance = new TraceRegistry();
+        return *pInstance;
+    }
+
+    ThreadTrace& Local()
+    {
+        ThreadTrace*& pLocal = LocalTrace();
+        if (!pLocal)
+        {
+            std::lock_guard guard{ m_mutex };
+            m_threads.push_back(std::make_unique<ThreadTrace>(
+              m_capacity, static_cast<std::uint32_t>(m_threads.size() + 1)));
+            pLocal = m_threads.back().get();
+            const std::string& name = LocalName();
+            pLocal->name = name.empty() ? "Thread " + std::to_string(pLocal->tid) : name;
+        }
+        return *pLocal;
+    }
+
+    /**
+     * Name the calling thread. Until the thread records its first
+     * event, only the name is stored, such that no ring is allocated
+     * for threads, which never record.
+     */
+    void NameSet(const std::string& name)
+    {
+        LocalName() = name;
+        if (ThreadTrace* pLocal = LocalTrace())
+        {
+            std::lock_guard guard{ m_mutex };
+            pLocal->name = name;
+        }
+    }
+
+    void Start(std::size_t capacity)
+    {
+        {
+            std::lock_guard guard{ m_mutex };
+            m_capacity = capacity;
+        }
+        m_origin.store(Clock::Now(), std::memory_order_relaxed);
+        m_enabled.store(true, std::memory_order_release);
+    }
+
+    void Stop() noexcept { m_enabled.store(false, std::memory_order_release); }
+
+    bool Enabled() const noexcept { return m_enabled.load(std::memory_order_relaxed); }
+
+    void WriteChromeJson(std::ostream& os) const;
+
+  private:
+    TraceRegistry() = default;
+
+    static ThreadTrace*& LocalTrace() noexcept
+    {
+        thread_local ThreadTrace* pLocal = nullptr;
+        return pLocal;
+    }
+
+    static std::string& LocalName() noexcept
+    {
+        thread_local std::string name;
+        return name;
+    }
+
+    mutable Mutex<"TraceRegistry::m_mutex"> m_mutex;
+    std::vector<std::unique_ptr<ThreadTrace>> m_threads;
+    std::size_t m_capacity{ DefaultCapacity };
+    std::atomic<Clock::Ticks> m_origin{ 0 }; ///< Events before the last Start() are skipped
+    std::atomic<bool> m_enabled{ false };
+};
+
+inline void WriteJsonString(std::ostream& os, const std::string& text)
+{
+    os << '"';
+    for (const char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            os << '\\' << c;
+        }
+        else if (static_cast<unsigned char>(c) >= 0x20)
+        {
+            os << c;
+        }
+    }
+    os << '"';
+}
+
+inline void TraceRegistry::WriteChromeJson(std::ostream& os) const
+{
+    const Clock::Ticks origin = m_origin.load(std::memory_order_relaxed);
+    const auto microseconds = [origin](Clock::Ticks ticks)
+    {
+        const Clock::Ticks elapsed = ticks > origin ? ticks - origin : 0;
+        return static_cast<double>(Clock::ToDuration(elapsed).count()) / 1000.0;
+    };
+
+    std::lock_guard guard{ m_mutex };
+    os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    const auto separate = [&]()
+    {
+        if (!first)
+        {
+            os << ",\n";
+        }
+        first = false;
+    };
+    std::uint64_t asyncId = 0;
+    for (const auto& pThread : m_threads)
+    {
+        separate();
+        os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << pThread->tid
+           << ",\"args\":{\"name\":";
+        WriteJsonString(os, pThread->name);
+        os << "}}";
+
+        auto reader = pThread->events.CreateReader(true);
+        Event event{};
+        while (pThread->events.TryRead(reader, event))
+        {
+            if (event.begin < origin)
+            {
+                continue;
+            }
+            separate();
+            if (event.type == EventType::Complete)
+            {
+                os << "{\"name\":";
+                WriteJsonString(os, event.name);
+                os << ",\"cat\":\"pbb\",\"ph\":\"X\",\"pid\":1,\"tid\":" << pThread->tid
+                   << ",\"ts\":" << microseconds(event.begin)
+                   << ",\"dur\":" << microseconds(event.end) - microseconds(event.begin);
+                if (event.argument != 0)
+                {
+                    os << ",\"args\":{\"key\":" << event.argument << "}";
+                }
+                os << "}";
+            }
+            else
+            {
+                // Async begin and end, since queue waits of a worker overlap
+                asyncId++;
+                for (const char* phase : { "b", "e" })
+                {
+                    const bool begin = phase[0] == 'b';
+                    os << "{\"name\":";
+                    WriteJsonString(os, event.name);
+                    os << ",\"cat\":\"queue\",\"ph\":\"" << phase << "\",\"id\":" << asyncId
+                       << ",\"pid\":1,\"tid\":" << pThread->tid
+                       << ",\"ts\":" << microseconds(begin ? event.begin : event.end) << "}";
+                    if (begin)
+                    {
+                        os << ",\n";
+                    }
+                }
+            }
+        }
+    }
+    os << "]}\n";
+}
+} // namespace detail
+
+/**
+ * Whether events are recorded, i.e. compiled with PBB_ENABLE_TRACE
+ * and started
+ */
+inline bool Enabled() noexcept
+{
+#ifdef PBB_ENABLE_TRACE
+    return detail::TraceRegistry::InstanceGet().Enabled();
+#else
+    return false;
+#endif
+}
+
+/**
+ * Start recording. Events recorded before are not exported.
+ *
+ * @param eventsPerThread - capacity of the ring of each thread
+ *                          recording its first event from now on
+ */
+inline void Start(
+  [[maybe_unused]] std::size_t eventsPerThread = detail::TraceRegistry::DefaultCapacity)
+{
+#ifdef PBB_ENABLE_TRACE
+    detail::TraceRegistry::InstanceGet().Start(eventsPerThread);
+#endif
+}
+
+inline void Stop() noexcept
+{
+#ifdef PBB_ENABLE_TRACE
+    detail::TraceRegistry::InstanceGet().Stop();
+#endif
+}
+
+/**
+ * Record an event on the calling thread, if tracing is enabled
+ */
+inline void Record([[maybe_unused]] const Event& event) noexcept
+{
+#ifdef PBB_ENABLE_TRACE
+    if (Enabled())
+    {
+        try
+        {
+            detail::TraceRegistry::InstanceGet().Local().events.Push(event);
+        }
+        catch (...)
+        {
+            // Registering the thread failed, drop the event
+        }
+    }
+#endif
+}
+
+/**
+ * Name the calling thread, both for the operating system, e.g. perf
+ * and top, and for the trace. Linux truncates the name to 15
+ * characters.
+ */
+inline void ThreadNameSet(const std::string& name)
+{
+#if defined(__linux__)
+    pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+#elif defined(__APPLE__)
+    pthread_setname_np(name.c_str());
+#endif
+#ifdef PBB_ENABLE_TRACE
+    detail::TraceRegistry::InstanceGet().NameSet(name);
+#endif
+}
+
+/**
+ * Export the recorded events of all threads as Chrome Trace Event
+ * JSON, which can be loaded into Perfetto. Safe to call while other
+ * threads record, in which case their latest events may be missing.
+ */
+inline void WriteChromeJson([[maybe_unused]] std::ostream& os)
+{
+#ifdef PBB_ENABLE_TRACE
+    detail::TraceRegistry::InstanceGet().WriteChromeJson(os);
+#else
+    os << "{\"traceEvents\":[]}\n";
+#endif
+}
+
+//! Region
+/*!
+  Record the lifetime of a scope on the calling thread, e.g. a
+  parallel loop or a frame. Compiles to nothing without
+  PBB_ENABLE_TRACE.
+ */
+class Region
+{
+  public:
+    explicit Region([[maybe_unused]] const char* name) noexcept
+#ifdef PBB_ENABLE_TRACE
+      : m_name(name)
+      , m_begin(Enabled() ? Clock::Now() : 0)
+#endif
+    {
+    }
+    PBB_DELETE_COPY_CTORS(Region);
+
+    ~Region()
+    {
+#ifdef PBB_ENABLE_TRACE
+        if (m_begin != 0)
+        {
+            Record({ m_begin, Clock::Now(), m_name, 0, EventType::Complete });
+        }
+#endif
+    }
+
+#ifdef PBB_ENABLE_TRACE
+  private:
+    const char* m_name;
+    Clock::Ticks m_begin;
+#endif
+};
+
+} // namespace PBB::Trace
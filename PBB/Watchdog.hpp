@@ -0,0 +1,298 @@
+/**
+ * @file   Watchdog.hpp
+ * @author Jens Munk Hansen <jens.munk.hansen@gmail.com>
+ * @date   Thu Oct 22 13:48:26 CEST 2026
+ *
+ * @brief  Stall watchdog and state dump of thread pools
+ *
+ * Copyright 2025 Jens Munk Hansen
+ *
+ */
+#pragma once
+
+#if __cplusplus < 202002L
+#error "This header requires at least C++20"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <PBB/Common.hpp>
+#include <PBB/Trace.hpp>
+#include <PBB/WorkerContext.hpp>
+
+namespace PBB::Thread
+{
+//! PoolState
+/*!
+  Activity of every worker of a pool and the number of queued tasks
+ */
+struct PoolState
+{
+    std::vector<WorkerActivity> workers;
+    std::size_t queueDepth{ 0 };
+};
+
+enum class StallKind : std::uint8_t
+{
+    Task,        ///< A task has run longer than the threshold
+    Initializer, ///< An init function has run longer than the threshold
+    Queue,       ///< Tasks have been queued, while no worker ran any
+};
+
+//! StallReport
+/*!
+  Reported once per stalled task, init function or starvation period
+ */
+struct StallReport
+{
+    StallKind kind{ StallKind::Task };
+    std::size_t worker{ WorkerContext::npos }; ///< Worker index, npos for the queue
+    const void* key{ nullptr };                ///< Init key of the stalled task
+    std::chrono::nanoseconds duration{ 0 };    ///< Time stalled when detected
+    std::size_t queueDepth{ 0 };               ///< Tasks queued when detected
+};
+
+inline const char* ToString(WorkerState state) noexcept
+{
+    switch (state)
+    {
+        case WorkerState::Idle:
+            return "idle";
+        case WorkerState::Running:
+            return "running";
+        case WorkerState::Initializing:
+            return "initializing";
+        default:
+            return "stopped";
+    }
+}
+
+/**
+ * Write a line per worker, e.g. "Worker 2: running key=0x... task 31"
+ */
+inline void WriteState(std::ostream& os, const PoolState& state)
+{
+    os << "Queue depth: " << state.queueDepth << '\n';
+    for (const WorkerActivity& worker : state.workers)
+    {
+        os << "Worker " << worker.index << ": " << ToString(worker.state);
+        if (worker.state == WorkerState::Running || worker.state == WorkerState::Initializing)
+        {
+            os << " key=" << worker.key << " task " << worker.taskSequence;
+            if (worker.runningFor.count() > 0)
+            {
+                os << " for "
+                   << std::chrono::duration_cast<std::chrono::milliseconds>(worker.runningFor)
+                        .count()
+                   << " ms";
+            }
+        }
+        os << '\n';
+    }
+}
+
+inline void WriteStall(std::ostream& os, const StallReport& report)
+{
+    const auto milliseconds =
+      std::chrono::duration_cast<std::chrono::milliseconds>(report.duration).count();
+    if (report.kind == StallKind::Queue)
+    {
+        os << "PBB watchdog: " << report.queueDepth << " queued task(s) not started for "
+           << milliseconds << " ms\n";
+        return;
+    }
+    os << "PBB watchdog: worker " << report.worker << " has been "
+       << (report.kind == StallKind::Task ? "running a task" : "initializing")
+       << " with key=" << report.key << " for " << milliseconds << " ms\n";
+}
+
+//! Watchdog
+/*!
+  Thread sampling the state of a pool periodically, which reports
+  tasks and init functions running longer than a threshold, and queued
+  tasks not started by any worker for longer than the threshold.
+
+  Workers only publish their state and a task sequence number, so the
+  duration of a task is measured by the watchdog from the first sample
+  seeing it, i.e. up to one period late, unless compiled with
+  PBB_ENABLE_STATS.
+ */
+class Watchdog
+{
+  public:
+    using Sampler = std::function<PoolState()>;
+    using StallHandler = std::function<void(const StallReport&)>;
+
+    /**
+     * Start the watchdog thread
+     *
+     * @param sampler - returns the current state of the pool
+     * @param threshold - duration after which a task is reported
+     * @param onStall - called on the watchdog thread, by default the
+     *                  report and the state are written to std::cerr
+     */
+    Watchdog(Sampler sampler, std::chrono::milliseconds threshold, StallHandler onStall = nullptr)
+      : m_sampler(std::move(sampler))
+      , m_threshold(threshold)
+      , m_period(std::max(threshold / 4, std::chrono::milliseconds(1)))
+      , m_onStall(std::move(onStall))
+      , m_dumpRequests(DumpRequests().load(std::memory_order_relaxed))
+    {
+        m_thread = std::thread([this]() { Run(); });
+    }
+    PBB_DELETE_COPY_CTORS(Watchdog);
+
+    ~Watchdog()
+    {
+        {
+            std::lock_guard<std::mutex> guard{ m_mutex };
+            m_stop = true;
+        }
+        m_condition.notify_all();
+        m_thread.join();
+    }
+
+    /**
+     * Install a handler for a signal, e.g. SIGUSR1, after which every
+     * watchdog writes the state of its pool to std::cerr
+     */
+    static void DumpOnSignal(int signal)
+    {
+        std::signal(signal, [](int) { DumpRequests().fetch_add(1, std::memory_order_relaxed); });
+    }
+
+  private:
+    // Incremented by the signal handler, which must not allocate or lock
+    static std::atomic<std::uint64_t>& DumpRequests() noexcept
+    {
+        static std::atomic<std::uint64_t> requests{ 0 };
+        return requests;
+    }
+
+    struct Tracked
+    {
+        std::uint64_t taskSequence{ 0 };
+        WorkerState state{ WorkerState::Stopped };
+        std::chrono::steady_clock::time_point since{};
+        bool reported{ false };
+    };
+
+    void Run()
+    {
+        Trace::ThreadNameSet("PBB watchdog");
+        std::unique_lock<std::mutex> lock{ m_mutex };
+        while (!m_condition.wait_for(lock, m_period, [this]() { return m_stop; }))
+        {
+            lock.unlock();
+            Sample();
+            lock.lock();
+        }
+    }
+
+    void Sample()
+    {
+        const PoolState state = m_sampler();
+        const auto now = std::chrono::steady_clock::now();
+        m_workers.resize(state.workers.size());
+
+        bool progress = false;
+        for (std::size_t i = 0; i < state.workers.size(); i++)
+        {
+            const WorkerActivity& worker = state.workers[i];
+            Tracked& tracked = m_workers[i];
+            if (worker.state != WorkerState::Running && worker.state != WorkerState::Initializing)
+            {
+                tracked.state = worker.state;
+                continue;
+            }
+            progress = true;
+            if (worker.taskSequence != tracked.taskSequence || worker.state != tracked.state)
+            {
+                using Duration = std::chrono::steady_clock::duration;
+                const auto elapsed = std::chrono::duration_cast<Duration>(worker.runningFor);
+                tracked = { worker.taskSequence, worker.state, now - elapsed, false };
+            }
+            const auto duration = now - tracked.since;
+            if (!tracked.reported && duration >= m_threshold)
+            {
+                tracked.reported = true;
+                Report({ worker.state == WorkerState::Running ? StallKind::Task
+                                                              : StallKind::Initializer,
+                         worker.index, worker.key, duration, state.queueDepth },
+                  state);
+            }
+        }
+
+        // Queued tasks, while every worker is idle
+        if (progress || state.queueDepth == 0)
+        {
+            m_starved.reset();
+        }
+        else if (!m_starved)
+        {
+            m_starved = Starved{ now, false };
+        }
+        else if (!m_starved->reported && now - m_starved->since >= m_threshold)
+        {
+            m_starved->reported = true;
+            Report({ StallKind::Queue, WorkerContext::npos, nullptr, now - m_starved->since,
+                     state.queueDepth },
+              state);
+        }
+
+        const std::uint64_t requests = DumpRequests().load(std::memory_order_relaxed);
+        if (requests != m_dumpRequests)
+        {
+            m_dumpRequests = requests;
+            WriteState(std::cerr, state);
+        }
+    }
+
+    void Report(const StallReport& report, const PoolState& state)
+    {
+        if (m_onStall)
+        {
+            m_onStall(report);
+            return;
+        }
+        WriteStall(std::cerr, report);
+        WriteState(std::cerr, state);
+    }
+
+    struct Starved
+    {
+        std::chrono::steady_clock::time_point since;
+        bool reported;
+    };
+
+    Sampler m_sampler;
+    const std::chrono::milliseconds m_threshold;
+    const std::chrono::milliseconds m_period;
+    StallHandler m_onStall;
+
+    // Only accessed by the watchdog thread
+    std::vector<Tracked> m_workers;
+    std::optional<Starved> m_starved;
+    std::uint64_t m_dumpRequests;
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stop{ false };
+    std::thread m_thread;
+};
+
+} // namespace PBB::Thread
@@ -0,0 +1,528 @@
+#pragma once
+
+#if __cplusplus < 202002L
+#error "This header requires C++20"
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <unordered_map>
+
+#include <PBB/Clock.hpp>
+#include <PBB/Common.hpp>
+#include <PBB/LatencyHistogram.hpp>
+#include <PBB/Memory.hpp>
+#include <PBB/ProfiledMutex.hpp>
+#include <PBB/Trace.hpp>
+
+#if defined(PBB_ENABLE_STATS) && defined(__linux__)
+#include <pthread.h>
+#include <time.h>
+#endif
+
+namespace PBB::Thread
+{
+
+//! ArenaResource
+/*!
+  Monotonic arena for task-scoped allocations. Deallocation is a no-op
+  and all memory is released at once by Reset(), which returns the
+  buffers to a per-worker pool resource, such that a steady state
+  does not touch the global heap. Keeps track of the largest number
+  of bytes allocated between two resets (high-water mark).
+ */
+class ArenaResource : public std::pmr::memory_resource
+{
+  public:
+    static constexpr std::size_t InitialSize = 64 * 1024;
+    static constexpr std::size_t LargestPooledBlock = 4 * 1024 * 1024;
+
+    ArenaResource()
+      : m_pool(std::pmr::pool_options{ 0, LargestPooledBlock })
+      , m_arena(InitialSize, &m_pool)
+    {
+    }
+    PBB_DELETE_COPY_CTORS(ArenaResource);
+
+    /**
+     * Release all memory allocated since the last reset
+     */
+    void Reset() noexcept
+    {
+        if (m_used != 0)
+        {
+            m_arena.release();
+            m_used = 0;
+        }
+    }
+
+    /**
+     * Bytes allocated since the last reset (owning worker only)
+     */
+    std::size_t Used() const noexcept { return m_used; }
+
+    /**
+     * Largest number of bytes allocated between two resets
+     */
+    std::size_t HighWater() const noexcept { return m_highWater.load(std::memory_order_relaxed); }
+
+  private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        void* p = m_arena.allocate(bytes, alignment);
+        m_used += bytes;
+        if (m_used > m_highWater.load(std::memory_order_relaxed))
+        {
+            m_highWater.store(m_used, std::memory_order_relaxed);
+        }
+        return p;
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override
+    {
+        m_arena.deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    std::pmr::unsynchronized_pool_resource m_pool;
+    std::pmr::monotonic_buffer_resource m_arena;
+    std::size_t m_used = 0;
+    std::atomic<std::size_t> m_highWater{ 0 };
+};
+
+//! WorkerSnapshot
+/*!
+  Execution statistics of a single worker. All values are zero, unless
+  compiled with PBB_ENABLE_STATS. The CPU time is only available on
+  Linux.
+ */
+struct WorkerSnapshot
+{
+    std::size_t index{ 0 };                 ///< Index of the worker
+    std::uint64_t tasksExecuted{ 0 };       ///< Tasks completed
+    std::chrono::nanoseconds busyTime{ 0 }; ///< Time spent executing tasks
+    std::chrono::nanoseconds idleTime{ 0 }; ///< Time spent waiting for tasks
+    std::chrono::nanoseconds cpuTime{ 0 };  ///< CPU time consumed by the thread
+
+    /**
+     * Percentage of the time spent executing tasks
+     */
+    double Utilization() const noexcept
+    {
+        const auto total = busyTime + idleTime;
+        return total.count() > 0
+          ? 100.0 * static_cast<double>(busyTime.count()) / static_cast<double>(total.count())
+          : 0.0;
+    }
+};
+
+enum class WorkerState : std::uint8_t
+{
+    Stopped,      ///< Not started or exited
+    Idle,         ///< Waiting for a task
+    Running,      ///< Executing a task
+    Initializing, ///< Executing the init function of a task's key
+};
+
+//! WorkerActivity
+/*!
+  What a worker is doing, sampled without stopping it. The task
+  sequence number changes whenever the worker starts a task, such that
+  a sampler can tell a long task from a series of short ones.
+ */
+struct WorkerActivity
+{
+    std::size_t index{ 0 };                   ///< Index of the worker
+    WorkerState state{ WorkerState::Stopped }; ///< Current state
+    const void* key{ nullptr };               ///< Init key of the current task
+    std::uint64_t taskSequence{ 0 };          ///< Number of tasks started
+    std::chrono::nanoseconds runningFor{ 0 }; ///< Time in the task, requires PBB_ENABLE_STATS
+};
+
+//! WorkerContext
+/*!
+  Per-worker state owned by a thread pool. Each worker thread installs
+  its context on start-up, such that code executing on a worker can
+  reach it through @ref WorkerContext::Current.
+ */
+class alignas(CACHE_LINE_SIZE) WorkerContext
+{
+  public:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    WorkerContext(const void* pOwner, std::size_t index)
+      : m_pOwner(pOwner)
+      , m_index(index)
+    {
+    }
+    PBB_DELETE_COPY_CTORS(WorkerContext);
+
+    /**
+     * Index of the worker in [0, NThreadsGet()) of the owning pool
+     */
+    std::size_t Index() const noexcept { return m_index; }
+
+    /**
+     * Pool owning the worker
+     */
+    const void* Owner() const noexcept { return m_pOwner; }
+
+    /**
+     * Memory resource for task-scoped allocations, e.g. for
+     * std::pmr containers. Memory is reclaimed when the task
+     * completes, so allocations must not outlive the task.
+     */
+    std::pmr::memory_resource* MemoryResource() noexcept { return &m_arena; }
+
+    /**
+     * Largest number of bytes allocated from the arena by a single task
+     */
+    std::size_t ArenaHighWater() const noexcept { return m_arena.HighWater(); }
+
+    /**
+     * Called by the worker thread when it starts and before it exits
+     */
+    void ThreadStarted() noexcept
+    {
+        m_state.store(WorkerState::Idle, std::memory_order_relaxed);
+#ifdef PBB_ENABLE_STATS
+        m_since.store(Clock::Now(), std::memory_order_relaxed);
+#ifdef __linux__
+        std::lock_guard guard{ m_cpuClockMutex };
+        m_hasCpuClock = pthread_getcpuclockid(pthread_self(), &m_cpuClock) == 0;
+#endif
+#endif
+    }
+
+    void ThreadStopped() noexcept
+    {
+        m_state.store(WorkerState::Stopped, std::memory_order_relaxed);
+#ifdef PBB_ENABLE_STATS
+        AddPeriod(m_idleTime, Clock::Now());
+        m_since.store(0, std::memory_order_relaxed);
+#ifdef __linux__
+        // The clock of an exited thread is invalid, keep its final value
+        std::lock_guard guard{ m_cpuClockMutex };
+        m_cpuTime = ThreadCpuTime(CLOCK_THREAD_CPUTIME_ID);
+        m_hasCpuClock = false;
+#endif
+#endif
+    }
+
+    /**
+     * Called by the worker loop when a task is about to execute
+     *
+     * @param submitted - @ref Clock ticks when the task was submitted, zero if unknown
+     * @param key - init key of the task
+     */
+    void BeginTask(
+      [[maybe_unused]] Clock::Ticks submitted, const void* key) noexcept
+    {
+        // Only written by the owning worker
+        m_currentKey.store(key, std::memory_order_relaxed);
+        m_taskSequence.store(
+          m_taskSequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        m_state.store(WorkerState::Running, std::memory_order_relaxed);
+#ifdef PBB_ENABLE_STATS
+        const Clock::Ticks now = Clock::Now();
+        AddPeriod(m_idleTime, now);
+        m_busy.store(true, std::memory_order_relaxed);
+        m_taskDelay = submitted != 0 && now > submitted ? now - submitted : 0;
+        m_taskKey = key;
+#endif
+#ifdef PBB_ENABLE_TRACE
+        if (Trace::Enabled())
+        {
+#ifndef PBB_ENABLE_STATS
+            const Clock::Ticks now = Clock::Now();
+#endif
+            m_traceSubmitted = submitted;
+            m_traceBegin = now;
+            m_traceKey = key;
+        }
+#endif
+    }
+
+    /**
+     * Called by the worker loop when a task has completed
+     */
+    void EndTask() noexcept
+    {
+        m_state.store(WorkerState::Idle, std::memory_order_relaxed);
+        m_arena.Reset();
+#ifdef PBB_ENABLE_TRACE
+        if (m_traceBegin != 0)
+        {
+            const Clock::Ticks now = Clock::Now();
+            if (m_traceSubmitted != 0 && m_traceSubmitted < m_traceBegin)
+            {
+                Trace::Record({ m_traceSubmitted, m_traceBegin, "Queued", 0,
+                  Trace::EventType::QueueWait });
+            }
+            Trace::Record({ m_traceBegin, now, "Task",
+              static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(m_traceKey)),
+              Trace::EventType::Complete });
+            m_traceBegin = 0;
+        }
+#endif
+#ifdef PBB_ENABLE_STATS
+        const Clock::Ticks runTime = AddPeriod(m_busyTime, Clock::Now());
+        m_busy.store(false, std::memory_order_relaxed);
+        // Only written by the owning worker
+        m_tasksExecuted.store(
+          m_tasksExecuted.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        m_latency.queueDelay.Record(m_taskDelay);
+        m_latency.runTime.Record(runTime);
+        if (m_latencyByKey.load(std::memory_order_relaxed))
+        {
+            RecordByKey(runTime);
+        }
+#endif
+    }
+
+    /**
+     * Called by the worker loop around the init function of a task
+     */
+    void BeginInitialize() noexcept
+    {
+        m_state.store(WorkerState::Initializing, std::memory_order_relaxed);
+    }
+
+    void EndInitialize() noexcept
+    {
+        m_state.store(WorkerState::Running, std::memory_order_relaxed);
+    }
+
+    /**
+     * Current state of the worker. Safe to call from any thread.
+     */
+    WorkerActivity Activity() const noexcept
+    {
+        WorkerActivity activity;
+        activity.index = m_index;
+        activity.taskSequence = m_taskSequence.load(std::memory_order_relaxed);
+        activity.state = m_state.load(std::memory_order_relaxed);
+        activity.key = m_currentKey.load(std::memory_order_relaxed);
+#ifdef PBB_ENABLE_STATS
+        const Clock::Ticks since = m_since.load(std::memory_order_relaxed);
+        const Clock::Ticks now = Clock::Now();
+        if (m_busy.load(std::memory_order_relaxed) && since != 0 && now > since)
+        {
+            activity.runningFor = Clock::ToDuration(now - since);
+        }
+#endif
+        return activity;
+    }
+
+    /**
+     * Also keep latency histograms per init key, which costs a lock
+     * and a lookup per task
+     */
+    void LatencyByKeySet([[maybe_unused]] bool enable) noexcept
+    {
+#ifdef PBB_ENABLE_STATS
+        m_latencyByKey.store(enable, std::memory_order_relaxed);
+#endif
+    }
+
+    /**
+     * Add the latency histograms of the worker to a target, which is
+     * not recorded to concurrently. Safe to call from any thread.
+     */
+    void MergeLatency([[maybe_unused]] TaskLatency& target) const noexcept
+    {
+#ifdef PBB_ENABLE_STATS
+        target.Merge(m_latency);
+#endif
+    }
+
+    /**
+     * Add the latency histograms of the tasks with a given init key
+     */
+    void MergeLatency([[maybe_unused]] const void* key,
+      [[maybe_unused]] TaskLatency& target) const noexcept
+    {
+#ifdef PBB_ENABLE_STATS
+        std::lock_guard guard{ m_latencyByKeyMutex };
+        if (auto it = m_latencyPerKey.find(key); it != m_latencyPerKey.end())
+        {
+            target.Merge(*it->second);
+        }
+#endif
+    }
+
+    /**
+     * Execution statistics of the worker, including the current busy
+     * or idle period. Safe to call from any thread. The values are read
+     * one by one, so they are only approximately consistent.
+     */
+    WorkerSnapshot Stats() const noexcept
+    {
+        WorkerSnapshot stats;
+        stats.index = m_index;
+#ifdef PBB_ENABLE_STATS
+        const Clock::Ticks since = m_since.load(std::memory_order_relaxed);
+        const Clock::Ticks now = Clock::Now();
+        const Clock::Ticks current = since != 0 && now > since ? now - since : 0;
+        const bool busy = m_busy.load(std::memory_order_relaxed);
+        stats.tasksExecuted = m_tasksExecuted.load(std::memory_order_relaxed);
+        stats.busyTime =
+          Clock::ToDuration(m_busyTime.load(std::memory_order_relaxed) + (busy ? current : 0));
+        stats.idleTime =
+          Clock::ToDuration(m_idleTime.load(std::memory_order_relaxed) + (busy ? 0 : current));
+#ifdef __linux__
+        std::lock_guard guard{ m_cpuClockMutex };
+        stats.cpuTime = m_hasCpuClock ? ThreadCpuTime(m_cpuClock) : m_cpuTime;
+#endif
+#endif
+        return stats;
+    }
+
+    /**
+     * Number of tasks completed by the worker, zero unless compiled
+     * with PBB_ENABLE_STATS
+     */
+    std::uint64_t TasksExecuted() const noexcept
+    {
+#ifdef PBB_ENABLE_STATS
+        return m_tasksExecuted.load(std::memory_order_relaxed);
+#else
+        return 0;
+#endif
+    }
+
+    /**
+     * Context of the calling thread, nullptr if not a worker thread
+     */
+    static WorkerContext* Current() noexcept { return CurrentRef(); }
+
+    /**
+     * Task-scoped memory resource of the calling worker. Falls back
+     * to the default memory resource, when not called from a worker.
+     */
+    static std::pmr::memory_resource* CurrentMemoryResource() noexcept
+    {
+        WorkerContext* pContext = Current();
+        return pContext ? pContext->MemoryResource() : std::pmr::get_default_resource();
+    }
+
+    //! Scope
+    /*!
+      Install a context as the current context of the calling thread
+      for the lifetime of the scope.
+     */
+    class Scope
+    {
+      public:
+        explicit Scope(WorkerContext& context) noexcept
+          : m_pPrevious(CurrentRef())
+        {
+            CurrentRef() = &context;
+        }
+        ~Scope() { CurrentRef() = m_pPrevious; }
+        PBB_DELETE_COPY_CTORS(Scope);
+
+      private:
+        WorkerContext* m_pPrevious;
+    };
+
+  private:
+    static WorkerContext*& CurrentRef() noexcept
+    {
+        thread_local WorkerContext* pCurrent = nullptr;
+        return pCurrent;
+    }
+
+#ifdef PBB_ENABLE_STATS
+    // Close the current period and add it to a total (owning worker only)
+    Clock::Ticks AddPeriod(std::atomic<Clock::Ticks>& total, Clock::Ticks now) noexcept
+    {
+        const Clock::Ticks since = m_since.load(std::memory_order_relaxed);
+        const Clock::Ticks period = since != 0 && now > since ? now - since : 0;
+        total.store(total.load(std::memory_order_relaxed) + period, std::memory_order_relaxed);
+        m_since.store(now, std::memory_order_relaxed);
+        return period;
+    }
+
+    // The sample is dropped, if the histograms of a new key cannot be allocated
+    void RecordByKey(Clock::Ticks runTime) noexcept
+    {
+        std::lock_guard guard{ m_latencyByKeyMutex };
+        try
+        {
+            auto& pLatency = m_latencyPerKey[m_taskKey];
+            if (!pLatency)
+            {
+                pLatency = std::make_unique<TaskLatency>();
+            }
+            pLatency->queueDelay.Record(m_taskDelay);
+            pLatency->runTime.Record(runTime);
+        }
+        catch (...)
+        {
+        }
+    }
+
+#ifdef __linux__
+    static std::chrono::nanoseconds ThreadCpuTime(clockid_t clock) noexcept
+    {
+        timespec ts{};
+        if (clock_gettime(clock, &ts) != 0)
+        {
+            return std::chrono::nanoseconds::zero();
+        }
+        return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+    }
+#endif
+#endif
+
+    const void* m_pOwner;
+    std::size_t m_index;
+    ArenaResource m_arena;
+
+    // Written by the owning worker, sampled by Activity()
+    std::atomic<WorkerState> m_state{ WorkerState::Stopped };
+    std::atomic<const void*> m_currentKey{ nullptr };
+    std::atomic<std::uint64_t> m_taskSequence{ 0 };
+#ifdef PBB_ENABLE_STATS
+    // Written by the owning worker, read by Stats(). Times are in Clock ticks.
+    std::atomic<std::uint64_t> m_tasksExecuted{ 0 };
+    std::atomic<Clock::Ticks> m_busyTime{ 0 };
+    std::atomic<Clock::Ticks> m_idleTime{ 0 };
+    std::atomic<Clock::Ticks> m_since{ 0 }; ///< Start of the current period, zero if stopped
+    std::atomic<bool> m_busy{ false };
+
+    // Latency of the current task and histograms
+    Clock::Ticks m_taskDelay{ 0 };
+    const void* m_taskKey{ nullptr };
+    std::atomic<bool> m_latencyByKey{ false };
+    TaskLatency m_latency;
+    mutable Mutex<"WorkerContext::m_latencyByKeyMutex"> m_latencyByKeyMutex;
+    std::unordered_map<const void*, std::unique_ptr<TaskLatency>> m_latencyPerKey;
+#ifdef __linux__
+    // CPU clock of the worker thread, read from other threads on demand,
+    // such that the worker loop never calls clock_gettime on it
+    mutable Mutex<"WorkerContext::m_cpuClockMutex"> m_cpuClockMutex;
+    clockid_t m_cpuClock{};
+    bool m_hasCpuClock{ false };
+    std::chrono::nanoseconds m_cpuTime{ 0 }; ///< Final value once the thread has stopped
+#endif
+#endif
+#ifdef PBB_ENABLE_TRACE
+    // Current task, zero begin if not traced
+    Clock::Ticks m_traceSubmitted{ 0 };
+    Clock::Ticks m_traceBegin{ 0 };
+    const void* m_traceKey{ nullptr };
+#endif
+};
+
+} // namespace PBB::Thread